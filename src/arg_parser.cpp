@@ -1,5 +1,6 @@
 #include "arg_parser.h"
 
+#include <cstdlib>
 #include <string>
 #include <fmt/format.h>
 
@@ -11,6 +12,17 @@ static void printUsage()
     fmt::println("  -h, --help       Show this help message");
     fmt::println("  -path <path>     Root directory containing lotro-data/ and lotro-items-db/");
     fmt::println("                   (default: C:\\projects)");
+    fmt::println("  --mmap           Memory map the XML files instead of reading them");
+    fmt::println("  --jobs <n>       Number of worker threads; 1 runs every stage in order");
+    fmt::println("                   (default: one per hardware thread)");
+    fmt::println("  --no-snapshot    Extract everything from XML and leave lore.snapshot alone");
+    fmt::println("                   (lore.snapshot is kept in the working directory)");
+    fmt::println("  --install        Write skill_input.toml and the Lua files straight into");
+    fmt::println("                   the TravelWindowII data/ and src/ folders");
+    fmt::println("  --profile        Print time, I/O and lookup counts per stage at exit");
+    fmt::println("                   and write them to profile.json");
+    fmt::println("  --check-kernels  Compare the string rewrites with their old regex versions");
+    fmt::println("                   over every label value and time both, then exit");
     fmt::println("");
     fmt::println("");
     fmt::println("Example:");
@@ -39,6 +51,36 @@ std::optional<ParsedArgs> parseArguments(int argc, const char **argv)
             }
             result.dataRoot = argv[i];
         }
+        else if(arg == "--mmap")
+        {
+            result.mapFiles = true;
+        }
+        else if(arg == "--no-snapshot")
+        {
+            result.useSnapshot = false;
+        }
+        else if(arg == "--install")
+        {
+            result.install = true;
+        }
+        else if(arg == "--profile")
+        {
+            result.profile = true;
+        }
+        else if(arg == "--check-kernels")
+        {
+            result.checkKernels = true;
+        }
+        else if(arg == "--jobs" || arg == "-j")
+        {
+            ++i;
+            if(i >= argc || atoi(argv[i]) <= 0)
+            {
+                printUsage();
+                return std::nullopt;
+            }
+            result.jobs = atoi(argv[i]);
+        }
     }
 
     return result;
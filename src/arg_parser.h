@@ -9,6 +9,12 @@ struct ParsedArgs
     std::string dataRoot;
     std::string twiiRoot;
     bool helpRequested{false};
+    bool mapFiles{false};
+    bool useSnapshot{true};
+    bool install{false};
+    bool profile{false};
+    bool checkKernels{false};
+    unsigned jobs{0}; // 0: one per hardware thread
 };
 
 std::optional<ParsedArgs> parseArguments(int argc, const char **argv);
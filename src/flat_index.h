@@ -0,0 +1,123 @@
+#ifndef FLAT_INDEX_H
+#define FLAT_INDEX_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash index from a member of T to its position in a vector
+//
+// Linear probing over a power of two table kept at most half full; each
+// slot holds a position + 1. The first element with a key wins like
+// ranges::find. Elements appended to the same buffer are added on the next
+// lookup, and the index is rebuilt when the vector was reallocated, replaced
+// or shrunk. Call invalidate() after changing keys in place. Lookups from
+// concurrent stages share the lock and only updates take it exclusively
+template<class T, auto Member>
+class FlatIndex
+{
+public:
+    FlatIndex() = default;
+    // copies start out stale and index their own vector
+    FlatIndex(const FlatIndex &) {}
+    FlatIndex &operator=(const FlatIndex &)
+    {
+        invalidate();
+        return *this;
+    }
+
+    template<class K>
+    T *find(std::vector<T> &values, const K &key)
+    {
+        return const_cast<T *>(find(std::as_const(values), key));
+    }
+
+    template<class K>
+    const T *find(const std::vector<T> &values, const K &key)
+    {
+        update(values);
+        std::shared_lock lock(m_mutex);
+        if(m_slots.empty())
+            return nullptr;
+        for(size_t slot = hash(key) & m_mask; m_slots[slot]; slot = (slot + 1) & m_mask)
+        {
+            const T &value = values[m_slots[slot] - 1];
+            if(value.*Member == key)
+                return &value;
+        }
+        return nullptr;
+    }
+
+    void invalidate()
+    {
+        std::unique_lock lock(m_mutex);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+private:
+    template<class K>
+    static size_t hash(const K &key)
+    {
+        uint64_t h;
+        if constexpr(std::is_integral_v<K>)
+            h = static_cast<uint64_t>(key);
+        else
+            h = std::hash<std::string_view>{}(key);
+        // fold the high bits down so ids sharing their low bits spread out
+        h *= 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    void update(const std::vector<T> &values)
+    {
+        {
+            std::shared_lock lock(m_mutex);
+            if(m_data == values.data() && m_size == values.size())
+                return;
+        }
+
+        std::unique_lock lock(m_mutex);
+        if(m_data == values.data() && m_size == values.size())
+            return;
+        if(m_data != values.data() || m_size > values.size())
+        {
+            m_size = 0;
+            m_slots.assign(std::bit_ceil(std::max<size_t>(16, values.size() * 2)), 0);
+            m_mask = m_slots.size() - 1;
+        }
+        else if(values.size() * 2 > m_slots.size())
+        {
+            m_size = 0;
+            m_slots.assign(std::bit_ceil(values.size() * 2), 0);
+            m_mask = m_slots.size() - 1;
+        }
+        m_data = values.data();
+
+        for(; m_size < values.size(); ++m_size)
+        {
+            const auto &key = values[m_size].*Member;
+            size_t slot = hash(key) & m_mask;
+            while(m_slots[slot] && !(values[m_slots[slot] - 1].*Member == key))
+                slot = (slot + 1) & m_mask;
+            if(!m_slots[slot])
+                m_slots[slot] = static_cast<uint32_t>(m_size + 1);
+        }
+    }
+
+private:
+    std::shared_mutex m_mutex;
+    const T *m_data{nullptr};
+    size_t m_size{0};
+    std::vector<uint32_t> m_slots;
+    size_t m_mask{0};
+};
+
+#endif // FLAT_INDEX_H
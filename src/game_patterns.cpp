@@ -0,0 +1,59 @@
+#include "game_patterns.h"
+
+#include <charconv>
+
+using namespace std;
+
+// the patterns these replace matched their free text with '.',
+// which stops at line breaks
+static bool isSingleLine(string_view text)
+{
+    return text.find_first_of("\n\r") == string_view::npos;
+}
+
+optional<GenderedName> parseGenderedName(string_view text)
+{
+    constexpr string_view prefix = "${PLAYERNAME:";
+    if(!text.starts_with(prefix) || !text.ends_with('}') || !isSingleLine(text))
+        return nullopt;
+    text.remove_prefix(prefix.size());
+    text.remove_suffix(1);
+
+    // text[gender] forms separated by '|'
+    GenderedName name;
+    while(true)
+    {
+        size_t open = text.find('[');
+        size_t close = text.find(']', open);
+        if(open == string_view::npos || close == string_view::npos)
+            return nullopt;
+        name.forms.push_back({text.substr(0, open), text.substr(open + 1, close - open - 1)});
+        text.remove_prefix(close + 1);
+        if(text.empty())
+            break;
+        if(text.front() != '|')
+            return nullopt;
+        text.remove_prefix(1);
+    }
+    if(name.forms.size() < 2)
+        return nullopt;
+    return name;
+}
+
+optional<unsigned> matchAllegianceLevel(string_view deed)
+{
+    constexpr string_view marker = "Allegiance Level ";
+    size_t digits = deed.find_last_not_of("0123456789") + 1;
+    if(digits == deed.size() || !deed.substr(0, digits).ends_with(marker) ||
+            !isSingleLine(deed))
+        return nullopt;
+
+    unsigned level = 0;
+    from_chars(deed.data() + digits, deed.data() + deed.size(), level);
+    return level;
+}
+
+bool isQuartermaster(string_view name)
+{
+    return name.ends_with(" Quartermaster") && isSingleLine(name);
+}
@@ -0,0 +1,34 @@
+#ifndef GAME_PATTERNS_H
+#define GAME_PATTERNS_H
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Matchers for the few grammars found inside game strings
+//
+// They replace std::regex patterns that were compiled on every call;
+// all of them work on views into the matched text.
+
+// a label whose wording depends on the player's gender, e.g.
+// ${PLAYERNAME:Verwandter[m]|Verwandte[f]}
+struct GenderedName
+{
+    struct Form
+    {
+        std::string_view text; // Verwandter
+        std::string_view gender; // m
+    };
+    std::vector<Form> forms;
+};
+
+// needs at least two forms; anything else is not a template
+std::optional<GenderedName> parseGenderedName(std::string_view text);
+
+// N from "<deed name> Allegiance Level N"
+std::optional<unsigned> matchAllegianceLevel(std::string_view deed);
+
+// "<name> Quartermaster"
+bool isQuartermaster(std::string_view name);
+
+#endif // GAME_PATTERNS_H
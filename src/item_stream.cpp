@@ -0,0 +1,537 @@
+#include "item_stream.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ITEM_STREAM_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ITEM_STREAM_SSE2
+#endif
+
+using namespace std;
+
+// first occurrence of needle in text
+//
+// Compares the first and last needle byte against a whole vector of
+// text at once and only runs memcmp on the positions where both match.
+static size_t findBytes(string_view text, string_view needle)
+{
+    const size_t n = needle.size();
+    if(n < 2 || text.size() < n)
+        return text.find(needle);
+
+    size_t i = 0;
+    const size_t starts = text.size() - n + 1;
+    const char *data = text.data();
+#if defined(ITEM_STREAM_AVX2)
+    const __m256i first = _mm256_set1_epi8(needle.front());
+    const __m256i last = _mm256_set1_epi8(needle.back());
+    for(; i + 32 <= starts; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + n - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while(mask)
+        {
+            unsigned bit = countr_zero(mask);
+            if(memcmp(data + i + bit + 1, needle.data() + 1, n - 2) == 0)
+                return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#elif defined(ITEM_STREAM_SSE2)
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+    for(; i + 16 <= starts; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + n - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while(mask)
+        {
+            unsigned bit = countr_zero(mask);
+            if(memcmp(data + i + bit + 1, needle.data() + 1, n - 2) == 0)
+                return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    return text.find(needle, i);
+}
+
+static size_t countBytes(string_view text, string_view needle)
+{
+    size_t count = 0;
+    size_t pos;
+    while((pos = findBytes(text, needle)) != string_view::npos)
+    {
+        ++count;
+        text.remove_prefix(pos + needle.size());
+    }
+    return count;
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static void appendUtf8(string &out, unsigned long cp)
+{
+    if(cp < 0x80)
+    {
+        out.push_back(static_cast<char>(cp));
+    }
+    else if(cp < 0x800)
+    {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else if(cp < 0x10000)
+    {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// same entity translation rapidxml applies to attribute values
+static void decodeValue(string_view in, string &out)
+{
+    out.clear();
+    size_t i = 0;
+    while(i < in.size())
+    {
+        size_t amp = in.find('&', i);
+        if(amp == string_view::npos)
+        {
+            out.append(in.substr(i));
+            break;
+        }
+        out.append(in.substr(i, amp - i));
+        i = amp;
+
+        string_view rest = in.substr(amp + 1);
+        size_t semi = rest.find(';');
+        if(semi == string_view::npos)
+        {
+            out.push_back('&');
+            ++i;
+            continue;
+        }
+        string_view entity = rest.substr(0, semi);
+        if(entity == "amp")
+            out.push_back('&');
+        else if(entity == "lt")
+            out.push_back('<');
+        else if(entity == "gt")
+            out.push_back('>');
+        else if(entity == "quot")
+            out.push_back('"');
+        else if(entity == "apos")
+            out.push_back('\'');
+        else if(entity.size() > 1 && entity[0] == '#')
+        {
+            string digits{entity.substr(1)};
+            int base = 10;
+            if(digits[0] == 'x')
+            {
+                digits.erase(0, 1);
+                base = 16;
+            }
+            appendUtf8(out, strtoul(digits.c_str(), nullptr, base));
+        }
+        else
+        {
+            out.push_back('&');
+            ++i;
+            continue;
+        }
+        i = amp + 1 + semi + 1;
+    }
+}
+
+static void parseAttributes(string_view tag, XMLAttributes &attrs)
+{
+    attrs.count = 0;
+
+    // skip '<' and the element name
+    size_t i = 1;
+    while(i < tag.size() && !isSpace(tag[i]) && tag[i] != '/' && tag[i] != '>')
+        ++i;
+
+    while(i < tag.size())
+    {
+        while(i < tag.size() && isSpace(tag[i]))
+            ++i;
+        if(i >= tag.size() || tag[i] == '/' || tag[i] == '>')
+            break;
+
+        size_t nameStart = i;
+        while(i < tag.size() && !isSpace(tag[i]) && tag[i] != '=')
+            ++i;
+        string_view name = tag.substr(nameStart, i - nameStart);
+
+        while(i < tag.size() && isSpace(tag[i]))
+            ++i;
+        if(i >= tag.size() || tag[i] != '=')
+            break;
+        ++i;
+        while(i < tag.size() && isSpace(tag[i]))
+            ++i;
+        if(i >= tag.size() || (tag[i] != '"' && tag[i] != '\''))
+            break;
+
+        char quote = tag[i++];
+        size_t valueEnd = tag.find(quote, i);
+        if(valueEnd == string_view::npos)
+            break;
+
+        if(attrs.count == attrs.values.size())
+            attrs.values.emplace_back();
+        auto &attr = attrs.values[attrs.count++];
+        attr.first.assign(name);
+        decodeValue(tag.substr(i, valueEnd - i), attr.second);
+        i = valueEnd + 1;
+    }
+}
+
+const char *XMLAttributes::get(string_view name) const
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(values[i].first == name)
+            return values[i].second.c_str();
+    }
+    return nullptr;
+}
+
+ItemStream::ItemStream(size_t chunkSize) :
+    m_chunkSize(chunkSize) {}
+
+bool ItemStream::open(const std::string &path, ItemRange range)
+{
+    m_file.open(path, ios::in | ios::binary);
+    if(!m_file.is_open())
+        return false;
+
+    m_remaining = range.end - range.begin;
+    if(range.begin)
+    {
+        m_file.seekg(range.begin);
+        m_depth = 1;
+    }
+    return m_file.good();
+}
+
+// items.xml puts every top level <item> on its own line with the same
+// indentation, so a range boundary is the next "\n<indent><item" after
+// an even split point
+std::vector<ItemRange> ItemStream::split(const std::string &path, unsigned parts)
+{
+    ifstream file(path, ios::in | ios::binary | ios::ate);
+    if(!file.is_open())
+        return {};
+    const uint64_t size = file.tellg();
+    if(parts <= 1 || size == 0)
+        return {ItemRange{0, size}};
+
+    constexpr size_t window = 64 * 1024;
+    string buf(window, '\0');
+    auto readAt = [&](uint64_t offset) -> string_view {
+        file.clear();
+        file.seekg(offset);
+        file.read(buf.data(), buf.size());
+        return {buf.data(), static_cast<size_t>(file.gcount())};
+    };
+
+    string_view head = readAt(0);
+    size_t first = head.find("<item ");
+    if(first == string_view::npos)
+        return {ItemRange{0, size}};
+    size_t lineStart = head.rfind('\n', first);
+    if(lineStart == string_view::npos)
+        return {ItemRange{0, size}};
+    const string marker{head.substr(lineStart, first - lineStart + 6)};
+
+    vector<ItemRange> ranges;
+    uint64_t begin = 0;
+    for(unsigned i = 1; i < parts; ++i)
+    {
+        uint64_t offset = max(size * i / parts, begin + 1);
+        uint64_t boundary = size;
+        while(offset < size)
+        {
+            string_view text = readAt(offset);
+            size_t found = findBytes(text, marker);
+            if(found != string_view::npos)
+            {
+                boundary = offset + found + 1;
+                break;
+            }
+            if(text.size() < marker.size())
+                break;
+            // overlap the windows so a marker is never cut in half
+            offset += text.size() - marker.size() + 1;
+        }
+        if(boundary >= size)
+            break;
+        ranges.push_back({begin, boundary});
+        begin = boundary;
+    }
+    ranges.push_back({begin, size});
+    return ranges;
+}
+
+// drops everything before m_pos and appends the next chunk
+bool ItemStream::fill()
+{
+    if(!m_file.is_open() || m_file.eof() || !m_remaining)
+        return false;
+
+    m_buf.erase(0, m_pos);
+    m_pos = 0;
+
+    size_t size = m_buf.size();
+    size_t chunk = static_cast<size_t>(min<uint64_t>(m_chunkSize, m_remaining));
+    m_buf.resize(size + chunk);
+    m_file.read(m_buf.data() + size, chunk);
+    size_t count = static_cast<size_t>(m_file.gcount());
+    m_buf.resize(size + count);
+    m_bytesRead += count;
+    m_remaining -= count;
+    Profiler::count(Profiler::Counter::Bytes, count);
+    return count > 0;
+}
+
+bool ItemStream::nextTag(Tag &tag)
+{
+    size_t start;
+    while((start = m_buf.find('<', m_pos)) == string::npos)
+    {
+        m_pos = m_buf.size();
+        if(!fill())
+            return false;
+    }
+    m_pos = start;
+
+    // enough to tell comments and CDATA sections from other markup
+    while(m_buf.size() - m_pos < 9 && fill())
+        ;
+    string_view head{m_buf.data() + m_pos, m_buf.size() - m_pos};
+    string_view close;
+    if(head.starts_with("<!--"))
+        close = "-->";
+    else if(head.starts_with("<![CDATA["))
+        close = "]]>";
+
+    // find the end of the markup; quoted attribute values may contain '>'
+    size_t end = string::npos;
+    size_t scanned = close.empty() ? 1 : 4;
+    char quote = 0;
+    while(true)
+    {
+        string_view text{m_buf.data() + m_pos, m_buf.size() - m_pos};
+        if(!close.empty())
+        {
+            size_t found = text.find(close, scanned);
+            if(found != string_view::npos)
+            {
+                end = found + close.size() - 1;
+                break;
+            }
+            if(text.size() > scanned + close.size())
+                scanned = text.size() - close.size();
+        }
+        else
+        {
+            for(; scanned < text.size(); ++scanned)
+            {
+                char c = text[scanned];
+                if(quote)
+                {
+                    if(c == quote)
+                        quote = 0;
+                }
+                else if(c == '"' || c == '\'')
+                {
+                    quote = c;
+                }
+                else if(c == '>')
+                {
+                    end = scanned;
+                    break;
+                }
+            }
+            if(end != string::npos)
+                break;
+        }
+
+        if(!fill())
+        {
+            m_error = true;
+            return false;
+        }
+    }
+
+    tag.text = string_view{m_buf.data() + m_pos, end + 1};
+    m_pos += end + 1;
+
+    tag.type = TagType::Other;
+    tag.selfClosing = false;
+    tag.name = {};
+    if(tag.text.size() < 3 || tag.text[1] == '!' || tag.text[1] == '?')
+        return true;
+
+    size_t nameStart = 1;
+    if(tag.text[1] == '/')
+    {
+        tag.type = TagType::End;
+        nameStart = 2;
+    }
+    else
+    {
+        tag.type = TagType::Start;
+        tag.selfClosing = tag.text[tag.text.size() - 2] == '/';
+    }
+    size_t nameEnd = nameStart;
+    while(nameEnd < tag.text.size() && !isSpace(tag.text[nameEnd]) &&
+            tag.text[nameEnd] != '/' && tag.text[nameEnd] != '>')
+        ++nameEnd;
+    tag.name = tag.text.substr(nameStart, nameEnd - nameStart);
+    return true;
+}
+
+// top level items start on their own line; the newline and indentation
+// in front of the first one seen become the marker skipItems() looks for
+void ItemStream::learnMarker(const Tag &tag)
+{
+    size_t start = tag.text.data() - m_buf.data();
+    size_t lineStart = start;
+    while(lineStart > 0 && (m_buf[lineStart - 1] == ' ' || m_buf[lineStart - 1] == '\t'))
+        --lineStart;
+    if(lineStart == 0 || m_buf[lineStart - 1] != '\n')
+        return;
+    m_marker = m_buf.substr(lineStart - 1, start - lineStart + 1);
+    m_marker += "<item ";
+}
+
+// called between two top level items; moves m_pos to the start of the
+// item that holds the next "<grants", or to the last item of the range
+// so its closing tags are still checked
+void ItemStream::skipItems()
+{
+    constexpr string_view grants = "<grants";
+
+    size_t scanned = 0; // relative to m_pos since fill() shifts the buffer
+    size_t grantsPos = string::npos;
+    while(true)
+    {
+        string_view text{m_buf.data() + m_pos, m_buf.size() - m_pos};
+        size_t found = findBytes(text.substr(scanned), grants);
+        if(found != string_view::npos)
+        {
+            grantsPos = scanned + found;
+            break;
+        }
+
+        // drop the items read so far before pulling in the next chunk
+        size_t last = text.rfind(m_marker);
+        if(last != string_view::npos && last > 0)
+        {
+            m_itemsSkipped += countBytes(text.substr(0, last), m_marker);
+            m_bytesSkipped += last;
+            m_pos += last;
+            text.remove_prefix(last);
+        }
+        scanned = text.size() > grants.size() ? text.size() - grants.size() + 1 : 0;
+        if(!fill())
+            return;
+    }
+
+    string_view text{m_buf.data() + m_pos, grantsPos};
+    size_t last = text.rfind(m_marker);
+    if(last == string_view::npos || last == 0)
+        return;
+    m_itemsSkipped += countBytes(text.substr(0, last), m_marker);
+    m_bytesSkipped += last;
+    m_pos += last;
+}
+
+bool ItemStream::next(ItemRecord &record)
+{
+    // <items> is depth 0, each <item> depth 1 and its children depth 2
+    constexpr unsigned itemDepth = 1;
+
+    Tag tag;
+    while(true)
+    {
+        if(!m_inItem && m_depth == itemDepth && !m_marker.empty())
+            skipItems();
+        if(!nextTag(tag))
+            break;
+
+        if(tag.type == TagType::Start)
+        {
+            Profiler::count(Profiler::Counter::Nodes);
+            if(m_depth == 0 && tag.name != "items")
+            {
+                m_error = true;
+                return false;
+            }
+            if(m_depth == itemDepth && tag.name == "item")
+            {
+                if(m_marker.empty())
+                    learnMarker(tag);
+                if(tag.selfClosing)
+                    continue;
+                m_itemTag.assign(tag.text);
+                m_inItem = true;
+                m_hasGrants = false;
+            }
+            else if(m_inItem && !m_hasGrants &&
+                    m_depth == itemDepth + 1 && tag.name == "grants")
+            {
+                m_grantsTag.assign(tag.text);
+                m_hasGrants = true;
+            }
+            if(!tag.selfClosing)
+                ++m_depth;
+        }
+        else if(tag.type == TagType::End)
+        {
+            if(m_depth == 0)
+            {
+                m_error = true;
+                return false;
+            }
+            --m_depth;
+            if(m_inItem && m_depth == itemDepth)
+            {
+                m_inItem = false;
+                if(m_hasGrants)
+                {
+                    parseAttributes(m_itemTag, record.item);
+                    parseAttributes(m_grantsTag, record.grants);
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,92 @@
+#ifndef ITEM_STREAM_H
+#define ITEM_STREAM_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+
+struct XMLAttributes
+{
+    const char *get(std::string_view name) const;
+    std::vector<std::pair<std::string, std::string>> values;
+    size_t count{0};
+};
+
+// an <item> element and its first <grants> child
+struct ItemRecord
+{
+    XMLAttributes item;
+    XMLAttributes grants;
+};
+
+// byte range of items.xml read by one ItemStream
+struct ItemRange
+{
+    uint64_t begin{0};
+    uint64_t end{UINT64_MAX};
+};
+
+// Pull parser for lotro-items-db/items.xml
+//
+// Only the start tags of the current <item> are kept, so memory
+// is bounded by the chunk size no matter how large the file is.
+// Items without a direct <grants> child are skipped.
+//
+// A stream may cover a byte range from split(); ranges after the
+// first start inside <items> at an <item> start tag.
+//
+// Between items the buffer is scanned for the next "<grants" and every
+// top level item before the one holding it is skipped without being
+// tokenized.
+class ItemStream
+{
+public:
+    explicit ItemStream(size_t chunkSize = 64 * 1024);
+
+    bool open(const std::string &path, ItemRange range = {});
+    bool next(ItemRecord &record);
+    bool error() const { return m_error; }
+    size_t bytesRead() const { return m_bytesRead; }
+    uint64_t bytesSkipped() const { return m_bytesSkipped; }
+    size_t itemsSkipped() const { return m_itemsSkipped; }
+
+    // up to parts ranges covering the file, split before top level <item>
+    static std::vector<ItemRange> split(const std::string &path, unsigned parts);
+
+private:
+    enum class TagType { Start, End, Other };
+    struct Tag
+    {
+        TagType type{TagType::Other};
+        bool selfClosing{false};
+        std::string_view name;
+        std::string_view text;
+    };
+
+    bool nextTag(Tag &tag);
+    bool fill();
+    void skipItems();
+    void learnMarker(const Tag &tag);
+
+private:
+    std::ifstream m_file;
+    std::string m_buf;
+    size_t m_pos{0};
+    size_t m_chunkSize;
+    size_t m_bytesRead{0};
+    uint64_t m_remaining{UINT64_MAX};
+    bool m_error{false};
+    uint64_t m_bytesSkipped{0};
+    size_t m_itemsSkipped{0};
+    std::string m_marker;
+
+    unsigned m_depth{0};
+    bool m_inItem{false};
+    bool m_hasGrants{false};
+    std::string m_itemTag;
+    std::string m_grantsTag;
+};
+
+#endif // ITEM_STREAM_H
@@ -0,0 +1,142 @@
+#include "kernel_check.h"
+#include "string_kernels.h"
+#include "transliterate.h"
+#include "xml_loader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <regex>
+#include <vector>
+#include <fmt/format.h>
+
+using namespace std;
+using namespace rapidxml;
+
+// the regex versions the kernels replaced, kept as the reference
+
+static string fixXmlStrRegex(string_view str)
+{
+    string buf;
+    auto out = back_inserter(buf);
+    std::regex quote("\\\\q");
+    std::regex_replace(out, str.begin(), str.end(), quote, "\\\"");
+    return buf;
+}
+
+static string escQuoteRegex(const string &in)
+{
+    return std::regex_replace(in, std::regex("\""), "\\\"");
+}
+
+static string convertToLuaGVarNameRegex(const string &in)
+{
+    string out;
+    transliterate(in, out);
+    std::replace(out.begin(), out.end(), ' ', '_');
+    std::replace(out.begin(), out.end(), '-', '_');
+    std::transform(out.begin(), out.end(), out.begin(), ::toupper);
+    std::erase_if(out, [](int c) { return c != '_' && !::isalnum(c); });
+    out = std::regex_replace(out, std::regex("THE_"), "");
+    out = std::regex_replace(out, std::regex("___"), "_");
+    return out;
+}
+
+// every value attribute of every <label>, files in path order
+static vector<string> loadLabelValues(const filesystem::path &labelsDir, size_t &fileCount)
+{
+    error_code ec;
+    vector<filesystem::path> files;
+    for(const auto &localeDir : filesystem::directory_iterator(labelsDir, ec))
+    {
+        if(!localeDir.is_directory())
+            continue;
+        for(const auto &entry : filesystem::directory_iterator(localeDir.path(), ec))
+        {
+            if(entry.is_regular_file() && entry.path().extension() == ".xml")
+                files.push_back(entry.path());
+        }
+    }
+    ranges::sort(files);
+
+    vector<string> values;
+    fileCount = 0;
+    for(const auto &file : files)
+    {
+        XMLLoader xml;
+        if(!xml.load(file.string()))
+        {
+            fmt::println("KERNELS: failed to load {}", file.string());
+            continue;
+        }
+        xml_node<> *root = xml.doc().first_node("labels");
+        if(!root)
+            continue;
+        ++fileCount;
+        for(xml_node<> *node = root->first_node("label");
+                node; node = node->next_sibling("label"))
+        {
+            if(xml_attribute<> *attr = node->first_attribute("value"))
+                values.emplace_back(attr->value(), attr->value_size());
+        }
+    }
+    return values;
+}
+
+template<class Regex, class Kernel>
+static size_t checkKernel(string_view name, const vector<string> &inputs,
+                          Regex regex, Kernel kernel, vector<string> &results)
+{
+    using Clock = chrono::steady_clock;
+    vector<string> expected;
+    expected.reserve(inputs.size());
+    auto start = Clock::now();
+    for(const auto &input : inputs)
+        expected.push_back(regex(input));
+    chrono::duration<double, milli> regexMs = Clock::now() - start;
+
+    results.clear();
+    results.reserve(inputs.size());
+    start = Clock::now();
+    for(const auto &input : inputs)
+        results.push_back(kernel(input));
+    chrono::duration<double, milli> kernelMs = Clock::now() - start;
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < inputs.size(); ++i)
+    {
+        if(expected[i] == results[i])
+            continue;
+        // the first few are enough to see what went wrong
+        if(++mismatches <= 10)
+            fmt::println("KERNELS: {} mismatch on \"{}\": regex \"{}\", kernel \"{}\"",
+                         name, inputs[i], expected[i], results[i]);
+    }
+    fmt::println("KERNELS: {:<20} regex {:>9.1f} ms, kernel {:>7.1f} ms ({:.1f}x), {} mismatches",
+                 name, regexMs.count(), kernelMs.count(),
+                 kernelMs.count() > 0 ? regexMs.count() / kernelMs.count() : 0.0, mismatches);
+    return mismatches;
+}
+
+bool checkStringKernels(const string &dataRoot)
+{
+    filesystem::path labelsDir = filesystem::path{dataRoot} / "lotro-data" / "lore" / "labels";
+    size_t fileCount = 0;
+    const vector<string> values = loadLabelValues(labelsDir, fileCount);
+    if(values.empty())
+    {
+        fmt::println("KERNELS: no label values found in {}", labelsDir.string());
+        return false;
+    }
+    fmt::println("KERNELS: {} label values from {} files", values.size(), fileCount);
+
+    // the later rewrites see labels the way the loader hands them out
+    vector<string> fixed;
+    vector<string> results;
+    size_t mismatches = checkKernel("fixXmlStr", values, fixXmlStrRegex, fixXmlStr, fixed);
+    mismatches += checkKernel("escQuote", fixed, escQuoteRegex, escQuote, results);
+    mismatches += checkKernel("convertToLuaGVarName", fixed,
+                              convertToLuaGVarNameRegex, convertToLuaGVarName, results);
+    return mismatches == 0;
+}
@@ -0,0 +1,12 @@
+#ifndef KERNEL_CHECK_H
+#define KERNEL_CHECK_H
+
+#include <string>
+
+// --check-kernels: runs the std::regex rewrites the string kernels replaced
+// and the kernels themselves over every label value under
+// <dataRoot>/lotro-data/lore/labels, printing each mismatch and the time
+// both versions took. Returns false when any output differs
+bool checkStringKernels(const std::string &dataRoot);
+
+#endif // KERNEL_CHECK_H
@@ -0,0 +1,409 @@
+#include "lore_extract.h"
+
+#include <functional>
+#include <fmt/format.h>
+#include "lore_snapshot.h"
+#include "profiler.h"
+#include "skill_input.h"
+#include "task_graph.h"
+
+using namespace std;
+
+// skill fields written by getCurrencies
+struct SkillBarters
+{
+    vector<vector<Barter>> barters; // per acquire entry
+    optional<Deed> barterDeed;
+    uint32_t factionId{0};
+    unsigned factionRank{0};
+};
+
+template<class Ar, class S> requires same_as<remove_const_t<S>, SkillBarters>
+void fields(Ar &ar, S &skill)
+{
+    ar(skill.barters, skill.barterDeed, skill.factionId, skill.factionRank);
+}
+
+struct CurrencyResult
+{
+    vector<SkillBarters> skills;
+    vector<Currency> currencies;
+    vector<NPC> npcs;
+};
+
+template<class Ar, class S> requires same_as<remove_const_t<S>, CurrencyResult>
+void fields(Ar &ar, S &result) { ar(result.skills, result.currencies, result.npcs); }
+
+// restores stage results from the snapshot or runs the stage and
+// stores what it extracted; every stage is run when there is no snapshot
+class StageCache
+{
+public:
+    StageCache(LoreSnapshot *snapshot, SourceHashes hashes) :
+        m_snapshot(snapshot)
+    {
+        for(auto &[path, hash] : hashes)
+            m_hashes.insert({std::move(path), hash});
+    }
+
+    // the upstream keys followed by the hashes of files
+    SourceHashes key(initializer_list<const SourceHashes *> upstream,
+                     const vector<string> &files) const
+    {
+        SourceHashes result;
+        for(const SourceHashes *sources : upstream)
+            result.insert(result.end(), sources->begin(), sources->end());
+        for(const auto &path : files)
+        {
+            auto it = m_hashes.find(path);
+            result.emplace_back(path, it != m_hashes.end() ? it->second : 0);
+        }
+        return result;
+    }
+
+    // scatter rejects results that no longer fit info, gather collects
+    // the stage's output after compute succeeded
+    template<class Result>
+    bool run(string_view stage, const SourceHashes &key,
+             const function<bool()> &compute,
+             const function<Result()> &gather,
+             const function<bool(Result &)> &scatter)
+    {
+        if(m_snapshot)
+        {
+            Result result;
+            if(m_snapshot->get(stage, key, result) && scatter(result))
+            {
+                note(stage, true);
+                return true;
+            }
+        }
+        if(!compute())
+            return false;
+        if(m_snapshot)
+        {
+            m_snapshot->set(stage, key, gather());
+            note(stage, false);
+        }
+        return true;
+    }
+
+    void report() const
+    {
+        if(!m_snapshot)
+            return;
+        lock_guard lock(m_mutex);
+        fmt::println("SNAPSHOT: reused {} of {} stages", m_reused,
+                     m_reused + m_recomputed);
+    }
+
+private:
+    void note(string_view stage, bool reused)
+    {
+        lock_guard lock(m_mutex);
+        fmt::println("SNAPSHOT: {} {}", reused ? "reused" : "recomputed", stage);
+        ++(reused ? m_reused : m_recomputed);
+    }
+
+private:
+    LoreSnapshot *m_snapshot;
+    unordered_map<string, uint64_t> m_hashes;
+    mutable mutex m_mutex;
+    unsigned m_reused{0};
+    unsigned m_recomputed{0};
+};
+
+static vector<string> labelPaths(const SkillLoader &loader, string_view file)
+{
+    vector<string> paths;
+    for(Locale lc : g_lcLabels)
+        paths.push_back(loader.labelPath(lc, file));
+    return paths;
+}
+
+static vector<string> concat(initializer_list<vector<string>> lists)
+{
+    vector<string> result;
+    for(const auto &list : lists)
+        result.insert(result.end(), list.begin(), list.end());
+    return result;
+}
+
+bool extractLore(SkillLoader &loader, TravelInfo &info, LoreSnapshot *snapshot)
+{
+    auto lore = [&](string_view file) { return loader.lorePath(file); };
+    auto labels = [&](string_view file) { return labelPaths(loader, file); };
+
+    // files read by each stage on its own
+    const vector<string> skillFiles = concat({
+        {lore("skills.xml"), loader.itemsPath(), lore("classes.xml"),
+         lore("quests.xml"), lore("traits.xml"), lore("deeds.xml"),
+         lore("allegiances.xml")},
+        labels("deeds.xml")});
+    const vector<string> nameFiles = labels("skills.xml");
+    const vector<string> questFiles = labels("quests.xml");
+    const vector<string> allegianceFiles = labels("allegiances.xml");
+    const vector<string> currencyFiles = concat({
+        {lore("barters.xml"), lore("deeds.xml"), lore("vendors.xml"),
+         lore("valueTables.xml"), lore("NPCs.xml")},
+        labels("deeds.xml")});
+    const vector<string> currencyLabelFiles = labels("items.xml");
+    const vector<string> npcFiles = labels("npc.xml");
+    const vector<string> factionFiles = {lore("factions.xml")};
+    const vector<string> factionLabelFiles = labels("factions.xml");
+
+    SourceHashes hashes;
+    if(snapshot)
+    {
+        ProfileScope scope("source hashes");
+        hashes = hashSources(loader.pool(), concat({
+            skillFiles, nameFiles, questFiles, allegianceFiles,
+            {loader.getTwiiRoot()}, currencyFiles, currencyLabelFiles,
+            npcFiles, factionFiles, factionLabelFiles}));
+    }
+    StageCache cache(snapshot, std::move(hashes));
+
+    // label stages only fill in names, so they are keyed by the
+    // structure they label; currencies run on the merged skills
+    const SourceHashes skillKey = cache.key({}, skillFiles);
+    const SourceHashes mergedKey = cache.key({&skillKey}, {loader.getTwiiRoot()});
+    const SourceHashes currencyKey = cache.key({&mergedKey}, currencyFiles);
+    const SourceHashes factionKey = cache.key({&currencyKey}, factionFiles);
+
+    // skill_input.toml does not depend on the lore files
+    TaskGraph stages;
+    auto skills = stages.add("skills", [&]
+    {
+        // an empty skill list is not fatal but never cached
+        cache.run<vector<Skill>>("skills", skillKey,
+            [&] { info.skills = loader.getSkills(); return !info.skills.empty(); },
+            [&] { return info.skills; },
+            [&](vector<Skill> &skills) { info.skills = std::move(skills); return true; });
+        return true;
+    });
+    using NameLabels = vector<pair<LCLabel, optional<LCLabel>>>;
+    auto names = stages.add("skill names", [&]
+    {
+        cache.run<NameLabels>("skill names", cache.key({&skillKey}, nameFiles),
+            [&] { return loader.getSkillNames(info.skills); },
+            [&]
+            {
+                NameLabels result;
+                for(const auto &skill : info.skills)
+                    result.emplace_back(skill.name, skill.desc);
+                return result;
+            },
+            [&](NameLabels &result)
+            {
+                if(result.size() != info.skills.size())
+                    return false;
+                for(size_t i = 0; i < result.size(); ++i)
+                {
+                    info.skills[i].name = std::move(result[i].first);
+                    info.skills[i].desc = std::move(result[i].second);
+                }
+                return true;
+            });
+        return true;
+    }, {skills});
+    auto quests = stages.add("quest labels", [&]
+    {
+        cache.run<vector<LCLabel>>("quest labels", cache.key({&skillKey}, questFiles),
+            [&] { return loader.getQuestLabels(info.skills); },
+            [&]
+            {
+                vector<LCLabel> result;
+                for(const auto &skill : info.skills)
+                {
+                    for(const auto &acquire : skill.acquire)
+                        result.push_back(acquire.questName);
+                }
+                return result;
+            },
+            [&](vector<LCLabel> &result)
+            {
+                size_t count = 0;
+                for(const auto &skill : info.skills)
+                    count += skill.acquire.size();
+                if(result.size() != count)
+                    return false;
+                auto label = result.begin();
+                for(auto &skill : info.skills)
+                {
+                    for(auto &acquire : skill.acquire)
+                        acquire.questName = std::move(*label++);
+                }
+                return true;
+            });
+        return true;
+    }, {skills});
+    auto allegiances = stages.add("allegiance labels", [&]
+    {
+        cache.run<vector<LCLabel>>("allegiance labels", cache.key({&skillKey}, allegianceFiles),
+            [&] { return loader.getAllegianceLabels(info.skills); },
+            [&]
+            {
+                vector<LCLabel> result;
+                for(const auto &skill : info.skills)
+                {
+                    if(skill.allegiance)
+                        result.push_back(skill.allegiance->name);
+                }
+                return result;
+            },
+            [&](vector<LCLabel> &result)
+            {
+                size_t count = ranges::count_if(info.skills,
+                        [](const Skill &skill) { return skill.allegiance.has_value(); });
+                if(result.size() != count)
+                    return false;
+                auto label = result.begin();
+                for(auto &skill : info.skills)
+                {
+                    if(skill.allegiance)
+                        skill.allegiance->name = std::move(*label++);
+                }
+                return true;
+            });
+        return true;
+    }, {skills});
+    auto inputs = stages.add("skill inputs", [&] { return loadSkillInputs(loader, info); });
+    auto merged = stages.add("merge inputs", [&]
+    {
+        getNewSkills(info);
+        return mergeSkillInputs(info, info.inputs);
+    }, {names, quests, allegiances, inputs});
+
+    auto currencies = stages.add("currencies", [&]
+    {
+        return cache.run<CurrencyResult>("currencies", currencyKey,
+            [&] { return loader.getCurrencies(info); },
+            [&]
+            {
+                CurrencyResult result{{}, info.currencies, info.npcs};
+                for(const auto &skill : info.skills)
+                {
+                    SkillBarters &barters = result.skills.emplace_back();
+                    for(const auto &acquire : skill.acquire)
+                        barters.barters.push_back(acquire.barters);
+                    barters.barterDeed = skill.barterDeed;
+                    barters.factionId = skill.factionId;
+                    barters.factionRank = skill.factionRank;
+                }
+                return result;
+            },
+            [&](CurrencyResult &result)
+            {
+                if(result.skills.size() != info.skills.size())
+                    return false;
+                for(size_t i = 0; i < result.skills.size(); ++i)
+                {
+                    if(result.skills[i].barters.size() != info.skills[i].acquire.size())
+                        return false;
+                }
+                for(size_t i = 0; i < result.skills.size(); ++i)
+                {
+                    Skill &skill = info.skills[i];
+                    SkillBarters &barters = result.skills[i];
+                    for(size_t j = 0; j < skill.acquire.size(); ++j)
+                        skill.acquire[j].barters = std::move(barters.barters[j]);
+                    skill.barterDeed = std::move(barters.barterDeed);
+                    skill.factionId = barters.factionId;
+                    skill.factionRank = barters.factionRank;
+                }
+                info.currencies = std::move(result.currencies);
+                info.npcs = std::move(result.npcs);
+                return true;
+            });
+    }, {merged});
+    stages.add("currency labels", [&]
+    {
+        return cache.run<vector<LCLabel>>("currency labels",
+            cache.key({&currencyKey}, currencyLabelFiles),
+            [&] { return loader.getCurrencyLabels(info); },
+            [&]
+            {
+                vector<LCLabel> result;
+                for(const auto &currency : info.currencies)
+                    result.push_back(currency.name);
+                return result;
+            },
+            [&](vector<LCLabel> &result)
+            {
+                if(result.size() != info.currencies.size())
+                    return false;
+                for(size_t i = 0; i < result.size(); ++i)
+                    info.currencies[i].name = std::move(result[i]);
+                return true;
+            });
+    }, {currencies});
+    using NPCLabels = vector<pair<LCLabel, LCLabel>>;
+    stages.add("NPC labels", [&]
+    {
+        return cache.run<NPCLabels>("NPC labels", cache.key({&currencyKey}, npcFiles),
+            [&] { return loader.getNPCLabels(info); },
+            [&]
+            {
+                NPCLabels result;
+                for(const auto &npc : info.npcs)
+                    result.emplace_back(npc.name, npc.title);
+                return result;
+            },
+            [&](NPCLabels &result)
+            {
+                if(result.size() != info.npcs.size())
+                    return false;
+                for(size_t i = 0; i < result.size(); ++i)
+                {
+                    info.npcs[i].name = std::move(result[i].first);
+                    info.npcs[i].title = std::move(result[i].second);
+                }
+                return true;
+            });
+    }, {currencies});
+
+    using FactionResult = pair<vector<Faction>, vector<RepRank>>;
+    auto factions = stages.add("factions", [&]
+    {
+        return cache.run<FactionResult>("factions", factionKey,
+            [&] { return loader.getFactions(info); },
+            [&] { return FactionResult{info.factions, info.repRanks}; },
+            [&](FactionResult &result)
+            {
+                info.factions = std::move(result.first);
+                info.repRanks = std::move(result.second);
+                return true;
+            });
+    }, {currencies});
+    using FactionLabels = pair<vector<LCLabel>, vector<LCLabel>>;
+    stages.add("faction labels", [&]
+    {
+        return cache.run<FactionLabels>("faction labels",
+            cache.key({&factionKey}, factionLabelFiles),
+            [&] { return loader.getFactionLabels(info); },
+            [&]
+            {
+                FactionLabels result;
+                for(const auto &faction : info.factions)
+                    result.first.push_back(faction.name);
+                for(const auto &rank : info.repRanks)
+                    result.second.push_back(rank.name);
+                return result;
+            },
+            [&](FactionLabels &result)
+            {
+                if(result.first.size() != info.factions.size() ||
+                        result.second.size() != info.repRanks.size())
+                    return false;
+                for(size_t i = 0; i < result.first.size(); ++i)
+                    info.factions[i].name = std::move(result.first[i]);
+                for(size_t i = 0; i < result.second.size(); ++i)
+                    info.repRanks[i].name = std::move(result.second[i]);
+                return true;
+            });
+    }, {factions});
+
+    bool ok = stages.run(loader.pool());
+    cache.report();
+    return ok;
+}
@@ -0,0 +1,16 @@
+#ifndef LORE_EXTRACT_H
+#define LORE_EXTRACT_H
+
+#include "skill_loader.h"
+
+class LoreSnapshot;
+
+// Runs the lore extraction and the skill input merge as one stage graph
+//
+// With a snapshot every stage is keyed by the hashes of the files it reads
+// plus the keys of the stages it builds on. Stages whose key is unchanged
+// patch their result from the snapshot into info instead of parsing XML;
+// the others run again and replace their section.
+bool extractLore(SkillLoader &loader, TravelInfo &info, LoreSnapshot *snapshot);
+
+#endif // LORE_EXTRACT_H
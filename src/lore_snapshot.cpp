@@ -0,0 +1,124 @@
+#include "lore_snapshot.h"
+#include "output_buffer.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <fmt/format.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+using namespace std;
+
+static constexpr string_view s_magic = "TWIISNAP";
+
+// hash of the running executable, so a rebuilt miner with different
+// extraction code never reuses the stage results of an older binary;
+// 0 when it cannot be read
+static uint64_t buildFingerprint()
+{
+    error_code ec;
+#if defined(_WIN32)
+    wchar_t buf[MAX_PATH];
+    DWORD size = GetModuleFileNameW(nullptr, buf, MAX_PATH);
+    if(size == 0 || size == MAX_PATH)
+        return 0;
+    filesystem::path exe{wstring{buf, size}};
+#else
+    filesystem::path exe = filesystem::read_symlink("/proc/self/exe", ec);
+    if(ec)
+        return 0;
+#endif
+    return hashFile(exe.string());
+}
+
+SourceHashes hashSources(ThreadPool &pool, const vector<string> &paths)
+{
+    vector<future<uint64_t>> hashes;
+    hashes.reserve(paths.size());
+    for(const auto &path : paths)
+        hashes.push_back(pool.submit([&path] { return hashFile(path); }));
+
+    SourceHashes sources;
+    sources.reserve(paths.size());
+    for(size_t i = 0; i < paths.size(); ++i)
+        sources.emplace_back(paths[i], pool.wait(hashes[i]));
+    return sources;
+}
+
+LoreSnapshot::LoreSnapshot(string path) :
+    m_path(std::move(path)),
+    m_build(buildFingerprint()) {}
+
+bool LoreSnapshot::load()
+{
+    lock_guard lock(m_mutex);
+    m_sections.clear();
+    m_changed = false;
+
+    ifstream file(m_path, ios::in | ios::binary);
+    if(!file.is_open())
+        return false;
+    string data{istreambuf_iterator<char>(file), istreambuf_iterator<char>()};
+    if(!string_view{data}.starts_with(s_magic))
+        return false;
+
+    SnapshotReader reader(string_view{data}.substr(s_magic.size()));
+    uint32_t version = 0;
+    reader(version);
+    if(version != Version)
+    {
+        fmt::println("SNAPSHOT: ignoring version {} (expected {})", version, Version);
+        return false;
+    }
+    uint64_t build = 0;
+    reader(build);
+    if(!m_build || build != m_build)
+    {
+        fmt::println("SNAPSHOT: ignoring {}, it was written by a different build", m_path);
+        return false;
+    }
+
+    vector<pair<string, Section>> sections;
+    uint64_t count = 0;
+    reader(count);
+    for(uint64_t i = 0; i < count && reader.ok(); ++i)
+    {
+        pair<string, Section> &section = sections.emplace_back();
+        reader(section.first, section.second.sources, section.second.data);
+    }
+    if(!reader.done())
+    {
+        fmt::println("SNAPSHOT: {} is truncated", m_path);
+        return false;
+    }
+
+    for(auto &[name, section] : sections)
+        m_sections.insert_or_assign(std::move(name), std::move(section));
+    return true;
+}
+
+// goes through writeFileAtomic so an interrupted
+// run never leaves a truncated snapshot behind
+bool LoreSnapshot::save() const
+{
+    lock_guard lock(m_mutex);
+    SnapshotWriter writer;
+    writer(Version, m_build, static_cast<uint64_t>(m_sections.size()));
+    for(const auto &[name, section] : m_sections)
+        writer(name, section.sources, section.data);
+
+    writer.data().insert(0, s_magic);
+    return writeFileAtomic(m_path, writer.data());
+}
+
+const string *LoreSnapshot::find(string_view name, const SourceHashes &sources) const
+{
+    // callers hold m_mutex
+    auto it = m_sections.find(name);
+    if(it == m_sections.end() || it->second.sources != sources)
+        return nullptr;
+    return &it->second.data;
+}
@@ -0,0 +1,312 @@
+#ifndef LORE_SNAPSHOT_H
+#define LORE_SNAPSHOT_H
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "skill_loader.h"
+
+// path and content hash of every file a section was extracted from;
+// files that could not be read hash to 0
+using SourceHashes = std::vector<std::pair<std::string, uint64_t>>;
+
+SourceHashes hashSources(ThreadPool &pool, const std::vector<std::string> &paths);
+
+// field lists shared by the writer and the reader; S is the
+// const qualified type when writing
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, LCLabel>
+void fields(Ar &ar, S &label) { ar(label.data, label.present); }
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, MapLoc>
+void fields(Ar &ar, S &loc) { ar(loc.region, loc.x, loc.y); }
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Token>
+void fields(Ar &ar, S &token) { ar(token.id, token.amt); }
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Barter>
+void fields(Ar &ar, S &barter)
+{
+    ar(barter.bartererId, barter.sellFactor, barter.buyAmt, barter.currency);
+}
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Deed>
+void fields(Ar &ar, S &deed) { ar(deed.id, deed.name); }
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Allegiance>
+void fields(Ar &ar, S &allegiance)
+{
+    ar(allegiance.id, allegiance.rank, allegiance.name);
+}
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Acquire>
+void fields(Ar &ar, S &acquire)
+{
+    ar(acquire.itemId, acquire.barters, acquire.valueTableId, acquire.level,
+       acquire.quality, acquire.questId, acquire.questNameKey, acquire.questName);
+}
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Skill>
+void fields(Ar &ar, S &skill)
+{
+    ar(skill.id, skill.nameId, skill.isNew, skill.isClass, skill.race,
+       skill.status, skill.group, skill.skillTag, skill.name, skill.desc,
+       skill.label, skill.zone, skill.zlabel, skill.detail, skill.tag,
+       skill.mapList, skill.overlapIds, skill.acquire, skill.acquireDesc,
+       skill.acquireDeed, skill.barterDeed, skill.allegiance,
+       skill.factionId, skill.factionRank, skill.minLevel, skill.minLevelInput,
+       skill.sortLevel, skill.storeLP, skill.autoLevel, skill.cat, skill.descKey);
+}
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Faction>
+void fields(Ar &ar, S &faction) { ar(faction.id, faction.name, faction.ranks); }
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, Currency>
+void fields(Ar &ar, S &currency) { ar(currency.id, currency.name); }
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, RepRank>
+void fields(Ar &ar, S &rank) { ar(rank.key, rank.name); }
+
+template<class Ar, class S> requires std::same_as<std::remove_const_t<S>, NPC>
+void fields(Ar &ar, S &npc) { ar(npc.id, npc.titleKey, npc.name, npc.title); }
+
+// appends values in native byte order; other types need a fields() overload
+class SnapshotWriter
+{
+public:
+    template<class... T>
+    void operator()(const T &...values) { (put(values), ...); }
+
+    std::string &data() { return m_data; }
+
+private:
+    template<class T>
+    void put(const T &value)
+    {
+        if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>)
+            m_data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        else
+            fields(*this, value);
+    }
+    void put(const std::string &value)
+    {
+        put(static_cast<uint64_t>(value.size()));
+        m_data.append(value);
+    }
+    template<class T, size_t N>
+    void put(const std::array<T, N> &values)
+    {
+        for(const auto &value : values)
+            put(value);
+    }
+    template<class T>
+    void put(const std::optional<T> &value)
+    {
+        put(value.has_value());
+        if(value)
+            put(*value);
+    }
+    template<class T>
+    void put(const std::vector<T> &values)
+    {
+        put(static_cast<uint64_t>(values.size()));
+        for(const auto &value : values)
+            put(value);
+    }
+    template<class K, class V>
+    void put(const std::pair<K, V> &value)
+    {
+        put(value.first);
+        put(value.second);
+    }
+    template<class K, class V>
+    void put(const std::map<K, V> &values)
+    {
+        put(static_cast<uint64_t>(values.size()));
+        for(const auto &value : values)
+            put(value);
+    }
+
+private:
+    std::string m_data;
+};
+
+// stops at the first read past the end; values read after
+// that are left default constructed
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(std::string_view data) : m_data(data) {}
+
+    template<class... T>
+    void operator()(T &...values) { (get(values), ...); }
+
+    bool ok() const { return m_ok; }
+    bool done() const { return m_ok && m_pos == m_data.size(); }
+
+private:
+    bool take(void *out, size_t size)
+    {
+        if(!m_ok || m_data.size() - m_pos < size)
+        {
+            m_ok = false;
+            return false;
+        }
+        std::memcpy(out, m_data.data() + m_pos, size);
+        m_pos += size;
+        return true;
+    }
+    // element count that cannot be larger than the bytes left
+    bool count(uint64_t &size)
+    {
+        if(!take(&size, sizeof(size)))
+            return false;
+        if(size > m_data.size() - m_pos)
+            m_ok = false;
+        return m_ok;
+    }
+
+    template<class T>
+    void get(T &value)
+    {
+        if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>)
+            take(&value, sizeof(value));
+        else
+            fields(*this, value);
+    }
+    void get(std::string &value)
+    {
+        uint64_t size;
+        if(!count(size))
+            return;
+        value.assign(m_data.substr(m_pos, size));
+        m_pos += size;
+    }
+    template<class T, size_t N>
+    void get(std::array<T, N> &values)
+    {
+        for(auto &value : values)
+            get(value);
+    }
+    template<class T>
+    void get(std::optional<T> &value)
+    {
+        bool hasValue = false;
+        get(hasValue);
+        if(hasValue && m_ok)
+            get(value.emplace());
+    }
+    template<class T>
+    void get(std::vector<T> &values)
+    {
+        uint64_t size;
+        if(!count(size))
+            return;
+        values.resize(size);
+        for(auto &value : values)
+            get(value);
+    }
+    template<class K, class V>
+    void get(std::pair<K, V> &value)
+    {
+        get(value.first);
+        get(value.second);
+    }
+    template<class K, class V>
+    void get(std::map<K, V> &values)
+    {
+        uint64_t size;
+        if(!count(size))
+            return;
+        values.clear();
+        for(uint64_t i = 0; i < size && m_ok; ++i)
+        {
+            std::pair<K, V> value;
+            get(value);
+            values.insert(std::move(value));
+        }
+    }
+
+private:
+    std::string_view m_data;
+    size_t m_pos{0};
+    bool m_ok{true};
+};
+
+// Versioned binary cache of the lore extraction, kept in the working directory
+// even when --install sends the outputs to the plugin folder
+//
+// Each section holds the result of one extraction stage keyed by the hashes
+// of its source files and is only handed out when all of them still match.
+// A different version, a different build of the miner or a truncated file
+// drops the whole snapshot.
+// Sections may be read and written from concurrent stages.
+class LoreSnapshot
+{
+public:
+    static constexpr uint32_t Version = 3;
+
+    explicit LoreSnapshot(std::string path = "lore.snapshot");
+
+    bool load();
+    bool save() const;
+    bool changed() const { return m_changed; }
+
+    // values are only assigned when the whole section decodes
+    template<class... T>
+    bool get(std::string_view name, const SourceHashes &sources, T &...values) const
+    {
+        std::tuple<T...> decoded;
+        {
+            std::lock_guard lock(m_mutex);
+            const std::string *data = find(name, sources);
+            if(!data)
+                return false;
+            SnapshotReader reader(*data);
+            std::apply([&](auto &...items) { reader(items...); }, decoded);
+            if(!reader.done())
+                return false;
+        }
+        std::apply([&](auto &...items) { ((values = std::move(items)), ...); }, decoded);
+        return true;
+    }
+
+    template<class... T>
+    void set(std::string_view name, SourceHashes sources, const T &...values)
+    {
+        SnapshotWriter writer;
+        writer(values...);
+        std::lock_guard lock(m_mutex);
+        m_sections.insert_or_assign(std::string{name},
+                                    Section{std::move(sources), std::move(writer.data())});
+        m_changed = true;
+    }
+
+private:
+    struct Section
+    {
+        SourceHashes sources;
+        std::string data;
+    };
+
+    const std::string *find(std::string_view name, const SourceHashes &sources) const;
+
+private:
+    std::string m_path;
+    uint64_t m_build{0}; // see buildFingerprint
+    std::map<std::string, Section, std::less<>> m_sections;
+    mutable std::mutex m_mutex;
+    bool m_changed{false};
+};
+
+#endif // LORE_SNAPSHOT_H
@@ -0,0 +1,80 @@
+#include "lua_names.h"
+#include "string_kernels.h"
+
+#include <fmt/format.h>
+
+using namespace std;
+
+static string_view kindName(LuaNames::Kind kind)
+{
+    switch(kind)
+    {
+    case LuaNames::Kind::Rep: return "rep";
+    case LuaNames::Kind::RepLevel: return "repLevel";
+    case LuaNames::Kind::Token: return "token";
+    default: return "UNKNOWN";
+    }
+}
+
+void LuaNames::clear()
+{
+    for(auto &table : m_tables)
+        table = {};
+    lock_guard lock(m_missMutex);
+    for(auto &misses : m_misses)
+        misses.clear();
+}
+
+void LuaNames::add(Kind kind, const string &name)
+{
+    Table &table = m_tables[static_cast<size_t>(kind)];
+    if(table.ids.contains(name))
+        return;
+
+    string id = convertToLuaGVarName(name);
+    auto [owner, inserted] = table.owners.try_emplace(id, name);
+    if(!inserted)
+        table.collisions.emplace_back(name, owner->second);
+    table.ids.emplace(name, std::move(id));
+}
+
+void LuaNames::reserve(Kind kind, string_view id)
+{
+    m_tables[static_cast<size_t>(kind)].owners.try_emplace(string{id},
+        fmt::format("LC.{}.{}", kindName(kind), id));
+}
+
+const string &LuaNames::get(Kind kind, const string &name) const
+{
+    const Table &table = m_tables[static_cast<size_t>(kind)];
+    auto it = table.ids.find(name);
+    if(it != table.ids.end())
+        return it->second;
+
+    // map nodes stay put, so the reference outlives the lock
+    lock_guard lock(m_missMutex);
+    auto &misses = m_misses[static_cast<size_t>(kind)];
+    auto [miss, inserted] = misses.try_emplace(name);
+    if(inserted)
+    {
+        fmt::println("LUA NAMES: \"{}\" was not added to LC.{}", name, kindName(kind));
+        miss->second = convertToLuaGVarName(name);
+    }
+    return miss->second;
+}
+
+size_t LuaNames::reportCollisions() const
+{
+    size_t count = 0;
+    for(size_t i = 0; i < m_tables.size(); ++i)
+    {
+        for(const auto &[name, owner] : m_tables[i].collisions)
+        {
+            fmt::println("LUA NAMES: \"{}\" maps to LC.{}.{}, already used by \"{}\"",
+                         name, kindName(static_cast<Kind>(i)),
+                         m_tables[i].ids.at(name), owner);
+            ++count;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,57 @@
+#ifndef LUA_NAMES_H
+#define LUA_NAMES_H
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Lua identifiers for the LC.rep, LC.repLevel and LC.token tables
+//
+// Every EN faction, rep rank and currency name is converted once when the
+// lore is loaded instead of for every skill that refers to it. Two names
+// converting to the same identifier would share one LC entry, so these
+// collisions are reported once all names are added.
+class LuaNames
+{
+public:
+    enum class Kind
+    {
+        Rep,
+        RepLevel,
+        Token,
+        Count
+    };
+
+    void clear();
+    void add(Kind kind, const std::string &name);
+    // an identifier written by hand, such as LC.token.GOLD
+    void reserve(Kind kind, std::string_view id);
+
+    // a name that was not added is reported once and converted into a
+    // separate miss table, so it never takes part in collision checks
+    const std::string &get(Kind kind, const std::string &name) const;
+
+    // prints every identifier shared by more than one name
+    size_t reportCollisions() const;
+
+private:
+    struct Table
+    {
+        std::unordered_map<std::string, std::string> ids; // by name
+        std::unordered_map<std::string, std::string> owners; // by identifier
+        std::vector<std::pair<std::string, std::string>> collisions; // name, owner
+    };
+
+private:
+    std::array<Table, static_cast<size_t>(Kind::Count)> m_tables;
+    // names get() was asked for that were never added, by kind
+    mutable std::array<std::unordered_map<std::string, std::string>,
+                       static_cast<size_t>(Kind::Count)> m_misses;
+    mutable std::mutex m_missMutex;
+};
+
+#endif // LUA_NAMES_H
@@ -6,6 +6,12 @@
 #include "skill_loader.h"
 #include "skill_input.h"
 #include "skill_output.h"
+#include "lore_extract.h"
+#include "lore_snapshot.h"
+#include "output_buffer.h"
+#include "profiler.h"
+#include "transliterate.h"
+#include "kernel_check.h"
 
 #if defined(_WIN32)
 #include <ShlObj_core.h>
@@ -99,6 +105,11 @@ int main(int argc, const char **argv)
         return 0;
     }
 
+    if(args->checkKernels)
+    {
+        return checkStringKernels(args->dataRoot) ? 0 : 1;
+    }
+
     if(args->twiiRoot.empty())
     {
         args->twiiRoot = getDefaultTwIIFolder();
@@ -110,29 +121,66 @@ int main(int argc, const char **argv)
         return 1;
     }
 
-    TravelInfo info;
-    SkillLoader loader(args->dataRoot, args->twiiRoot);
-    info.skills = loader.getSkills();
-    if(!loadSkillInputs(loader, info))
+    if(args->mapFiles)
     {
-        return 1;
+        XMLLoader::setMode(XMLLoader::Mode::Mapped);
     }
-    getNewSkills(info);
-    if(!mergeSkillInputs(info, info.inputs))
+    if(args->profile)
     {
-        return 1;
+        Profiler::enable();
+    }
+
+    TravelInfo info;
+    SkillLoader loader(args->dataRoot, args->twiiRoot,
+                       args->jobs ? args->jobs : ThreadPool::defaultThreads());
+
+    optional<LoreSnapshot> snapshot;
+    if(args->useSnapshot)
+    {
+        ProfileScope scope("snapshot load");
+        snapshot.emplace();
+        snapshot->load();
     }
-    if(!loader.getCurrencies(info))
+    if(!extractLore(loader, info, snapshot ? &*snapshot : nullptr))
     {
         return 1;
     }
-    if(!loader.getFactions(info))
+    if(snapshot && snapshot->changed())
     {
-        return 1;
+        ProfileScope scope("snapshot save");
+        if(!snapshot->save())
+            fmt::println("SNAPSHOT: failed to write lore.snapshot");
     }
 
-    generateNewSkillInputFile(info);
-    outputSkillDataFile(info);
-    outputLocaleDataFile(info);
-    return 0;
+    // files that did not change are left alone so the plugin
+    // only reloads when there is something new
+    string dataDir = args->install ? fmt::format("{}/data/", args->twiiRoot) : "";
+    string srcDir = args->install ? fmt::format("{}/src/", args->twiiRoot) : "";
+    buildLuaNames(info);
+    OutputSummary outputs;
+    {
+        ProfileScope scope("skill_input.toml");
+        generateNewSkillInputFile(info, dataDir + "skill_input.toml", outputs);
+    }
+    {
+        ProfileScope scope("SkillData.lua");
+        outputSkillDataFile(info, srcDir + "SkillData.lua", outputs);
+    }
+    {
+        ProfileScope scope("LocaleData.lua");
+        outputLocaleDataFile(info, srcDir + "LocaleData.lua", outputs);
+    }
+    outputs.print();
+    reportUnknownCodepoints();
+
+    auto xmlStats = XMLLoader::stats();
+    fmt::println("XML: mapped {} files ({} bytes), copied {} files ({} bytes)",
+                 xmlStats.filesMapped, xmlStats.bytesMapped,
+                 xmlStats.filesCopied, xmlStats.bytesCopied);
+    fmt::println("XML cache: {} hits, {} misses",
+                 loader.documents().hits(), loader.documents().misses());
+    Profiler::report();
+    if(!Profiler::writeJson("profile.json"))
+        fmt::println("PROFILE: failed to write profile.json");
+    return outputs.ok() ? 0 : 1;
 }
@@ -0,0 +1,137 @@
+#include "output_buffer.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+
+static constexpr uint64_t s_hashPrime = 0x9E3779B97F4A7C15ull;
+static constexpr uint64_t s_hashSeed = 0xCBF29CE484222325ull;
+
+// multiply-xorshift over 8 byte words; only the last
+// block of a stream may have a length that is not a multiple of 8
+static uint64_t hashBlock(uint64_t hash, const char *data, size_t count)
+{
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * s_hashPrime;
+        hash ^= hash >> 32;
+    }
+    for(; i < count; ++i)
+    {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * s_hashPrime;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+static uint64_t hashFinish(uint64_t hash, uint64_t length)
+{
+    hash = (hash ^ length) * s_hashPrime;
+    return (hash ^ (hash >> 29)) | 1;
+}
+
+uint64_t hashFile(const string &path)
+{
+    ifstream file(path, ios::in | ios::binary);
+    if(!file.is_open())
+        return 0;
+
+    uint64_t hash = s_hashSeed;
+    uint64_t length = 0;
+    string buf(1 << 20, '\0');
+    while(file)
+    {
+        file.read(buf.data(), buf.size());
+        size_t count = static_cast<size_t>(file.gcount());
+        length += count;
+        hash = hashBlock(hash, buf.data(), count);
+        Profiler::count(Profiler::Counter::Bytes, count);
+    }
+    return hashFinish(hash, length);
+}
+
+uint64_t hashContent(string_view data)
+{
+    return hashFinish(hashBlock(s_hashSeed, data.data(), data.size()), data.size());
+}
+
+bool writeFileAtomic(const std::string &path, std::string_view data)
+{
+    namespace fsys = std::filesystem;
+
+    string tmpPath = path + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if(!file)
+        return false;
+    bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = fclose(file) == 0 && written;
+
+    error_code ec;
+    if(written)
+        fsys::rename(tmpPath, path, ec);
+    if(!written || ec)
+    {
+        fsys::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+WriteResult writeFileIfChanged(const std::string &path, std::string_view data)
+{
+    // a size mismatch settles it without reading the old file
+    error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if(!ec && size == data.size() && hashFile(path) == hashContent(data))
+        return WriteResult::Unchanged;
+    return writeFileAtomic(path, data) ? WriteResult::Written : WriteResult::Failed;
+}
+
+bool OutputSummary::write(const std::string &path, const OutputBuffer &out)
+{
+    WriteResult result = writeFileIfChanged(path, out.view());
+    m_files.push_back({path, out.size(), result});
+    if(result == WriteResult::Failed)
+    {
+        fmt::println("Failed to create {}", path);
+        return false;
+    }
+    return true;
+}
+
+bool OutputSummary::ok() const
+{
+    return ranges::none_of(m_files, [](const File &file) {
+        return file.result == WriteResult::Failed;
+    });
+}
+
+void OutputSummary::print() const
+{
+    size_t written = 0;
+    for(const auto &file : m_files)
+    {
+        switch(file.result)
+        {
+        case WriteResult::Unchanged:
+            fmt::println("OUTPUT: unchanged {}", file.path);
+            break;
+        case WriteResult::Written:
+            fmt::println("OUTPUT: updated {} ({} bytes)", file.path, file.bytes);
+            ++written;
+            break;
+        case WriteResult::Failed:
+            fmt::println("OUTPUT: failed {}", file.path);
+            break;
+        }
+    }
+    fmt::println("OUTPUT: {} of {} files changed", written, m_files.size());
+}
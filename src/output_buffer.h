@@ -0,0 +1,79 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+
+// Append-only text buffer for generated files
+//
+// Output helpers format straight into a single fmt::memory_buffer and
+// the finished file is handed to OutputSummary::write.
+class OutputBuffer
+{
+public:
+    template<typename... T>
+    void print(fmt::format_string<T...> format, T &&...args)
+    {
+        fmt::format_to(fmt::appender(m_buf), format, std::forward<T>(args)...);
+    }
+    template<typename... T>
+    void println(fmt::format_string<T...> format, T &&...args)
+    {
+        print(format, std::forward<T>(args)...);
+        m_buf.push_back('\n');
+    }
+    void append(std::string_view text) { m_buf.append(text.data(), text.data() + text.size()); }
+
+    // lets a helper drop what it wrote since size()
+    size_t size() const { return m_buf.size(); }
+    void truncate(size_t size) { m_buf.resize(size); }
+
+    std::string_view view() const { return {m_buf.data(), m_buf.size()}; }
+
+private:
+    fmt::memory_buffer m_buf;
+};
+
+// writes data to <path>.tmp with one call and renames it over path,
+// so a failed or interrupted run never leaves a partial file behind
+bool writeFileAtomic(const std::string &path, std::string_view data);
+
+// 64 bit content hashes; files that could not be read hash to 0
+uint64_t hashFile(const std::string &path);
+uint64_t hashContent(std::string_view data);
+
+enum class WriteResult
+{
+    Unchanged,
+    Written,
+    Failed
+};
+
+// leaves path untouched when it already holds data so plugin reloads
+// and file syncing only see files that really changed
+WriteResult writeFileIfChanged(const std::string &path, std::string_view data);
+
+// what one run did to each generated file
+class OutputSummary
+{
+public:
+    bool write(const std::string &path, const OutputBuffer &out);
+
+    bool ok() const;
+    void print() const;
+
+private:
+    struct File
+    {
+        std::string path;
+        size_t bytes;
+        WriteResult result;
+    };
+    std::vector<File> m_files;
+};
+
+#endif // OUTPUT_BUFFER_H
@@ -0,0 +1,218 @@
+#include "profiler.h"
+#include "output_buffer.h"
+
+#include <fmt/format.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+using namespace std;
+
+std::atomic<bool> Profiler::s_enabled{false};
+std::mutex Profiler::s_mutex;
+std::deque<Profiler::Stage> Profiler::s_stages;
+
+static thread_local Profiler::Stage *t_stage = nullptr;
+// CPU time already charged by scopes nested in the innermost open one
+static thread_local uint64_t t_nestedCpu = 0;
+
+static uint64_t threadCpuNs()
+{
+#if defined(_WIN32)
+    FILETIME created, exited, kernel, user;
+    if(!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user))
+        return 0;
+    auto ticks = [](const FILETIME &time)
+    {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) * 100;
+#else
+    timespec time{};
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+        return 0;
+    return static_cast<uint64_t>(time.tv_sec) * 1000000000ull + time.tv_nsec;
+#endif
+}
+
+static uint64_t peakRssBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+static uint64_t load(const atomic<uint64_t> &value)
+{
+    return value.load(memory_order_relaxed);
+}
+
+void Profiler::enable()
+{
+    s_enabled = true;
+}
+
+Profiler::Stage *Profiler::current()
+{
+    return t_stage;
+}
+
+void Profiler::count(Counter counter, uint64_t amount)
+{
+    if(Stage *stage = t_stage)
+        stage->counters[static_cast<size_t>(counter)].fetch_add(amount, memory_order_relaxed);
+}
+
+// stages are keyed by their path so a stage run again,
+// or from several threads, keeps a single row
+Profiler::Stage *Profiler::stage(Stage *parent, string_view name)
+{
+    string path = parent ? fmt::format("{}/{}", parent->path, name) : string{name};
+    lock_guard lock(s_mutex);
+    for(auto &stage : s_stages)
+    {
+        if(stage.path == path)
+            return &stage;
+    }
+    Stage &stage = s_stages.emplace_back();
+    stage.path = std::move(path);
+    stage.name = name;
+    stage.depth = parent ? parent->depth + 1 : 0;
+    return &stage;
+}
+
+void Profiler::report()
+{
+    if(!enabled())
+        return;
+    lock_guard lock(s_mutex);
+    fmt::println("PROFILE: {:<36} {:>5} {:>10} {:>10} {:>12} {:>10} {:>10} {:>9}",
+                 "stage", "runs", "wall ms", "cpu ms", "bytes", "nodes", "lookups", "rss KB");
+    for(const auto &stage : s_stages)
+    {
+        string name = fmt::format("{:{}}{}", "", stage.depth * 2, stage.name);
+        fmt::println("PROFILE: {:<36} {:>5} {:>10.1f} {:>10.1f} {:>12} {:>10} {:>10} {:>9}",
+                     name, load(stage.runs),
+                     load(stage.wallNs) / 1e6, load(stage.cpuNs) / 1e6,
+                     load(stage.counters[static_cast<size_t>(Counter::Bytes)]),
+                     load(stage.counters[static_cast<size_t>(Counter::Nodes)]),
+                     load(stage.counters[static_cast<size_t>(Counter::Lookups)]),
+                     load(stage.rssDelta) / 1024);
+    }
+}
+
+// stage names are plain ASCII, so only quotes and backslashes are escaped
+static string jsonString(string_view text)
+{
+    string out{"\""};
+    for(char c : text)
+    {
+        if(c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+bool Profiler::writeJson(const string &path)
+{
+    if(!enabled())
+        return true;
+    lock_guard lock(s_mutex);
+    OutputBuffer out;
+    out.println("{{");
+    out.println("    \"stages\": [");
+    for(auto it = s_stages.begin(); it != s_stages.end(); ++it)
+    {
+        const Stage &stage = *it;
+        out.println("        {{");
+        out.println("            \"path\": {},", jsonString(stage.path));
+        out.println("            \"name\": {},", jsonString(stage.name));
+        out.println("            \"depth\": {},", stage.depth);
+        out.println("            \"runs\": {},", load(stage.runs));
+        out.println("            \"wall_ns\": {},", load(stage.wallNs));
+        out.println("            \"cpu_ns\": {},", load(stage.cpuNs));
+        out.println("            \"bytes_read\": {},",
+                    load(stage.counters[static_cast<size_t>(Counter::Bytes)]));
+        out.println("            \"xml_nodes\": {},",
+                    load(stage.counters[static_cast<size_t>(Counter::Nodes)]));
+        out.println("            \"lookups\": {},",
+                    load(stage.counters[static_cast<size_t>(Counter::Lookups)]));
+        out.println("            \"peak_rss_delta_bytes\": {}", load(stage.rssDelta));
+        out.println("        }}{}", std::next(it) != s_stages.end() ? "," : "");
+    }
+    out.println("    ]");
+    out.println("}}");
+    return writeFileAtomic(path, out.view());
+}
+
+ProfileScope::ProfileScope(string_view name)
+{
+    if(!Profiler::enabled())
+        return;
+    m_stage = Profiler::stage(t_stage, name);
+    m_stage->runs.fetch_add(1, memory_order_relaxed);
+    m_timed = true;
+    m_wallStart = chrono::steady_clock::now();
+    m_peakStart = peakRssBytes();
+    enter();
+}
+
+// a task queued outside of any stage clears the thread's stage, so a
+// worker helping out from inside a stage does not charge it that task
+ProfileScope::ProfileScope(Profiler::Stage *stage)
+{
+    if(!Profiler::enabled())
+        return;
+    m_stage = stage;
+    enter();
+}
+
+void ProfileScope::enter()
+{
+    m_active = true;
+    m_prev = t_stage;
+    t_stage = m_stage;
+    m_outerNested = t_nestedCpu;
+    t_nestedCpu = 0;
+    m_cpuStart = threadCpuNs();
+}
+
+ProfileScope::~ProfileScope()
+{
+    if(!m_active)
+        return;
+    uint64_t total = threadCpuNs() - m_cpuStart;
+    if(m_stage)
+        m_stage->cpuNs.fetch_add(total - min(t_nestedCpu, total), memory_order_relaxed);
+    t_nestedCpu = m_outerNested + total;
+    t_stage = m_prev;
+
+    if(!m_timed)
+        return;
+    auto wall = chrono::steady_clock::now() - m_wallStart;
+    m_stage->wallNs.fetch_add(
+        static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(wall).count()),
+        memory_order_relaxed);
+    uint64_t peak = peakRssBytes();
+    m_stage->rssDelta.fetch_add(peak > m_peakStart ? peak - m_peakStart : 0,
+                                memory_order_relaxed);
+}
@@ -0,0 +1,90 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Per-stage counters for --profile
+//
+// Every thread charges its work to the stage it is running, which a
+// ProfileScope sets and ThreadPool::submit carries into queued tasks, so
+// work a stage hands to the pool still counts towards it. Stages opened
+// inside another stage are listed below it. All calls are no-ops until
+// enable() has been called
+class Profiler
+{
+public:
+    enum class Counter
+    {
+        Bytes, // read from disk
+        Nodes, // XML elements parsed or scanned
+        Lookups, // index and document cache lookups
+        Count
+    };
+
+    struct Stage
+    {
+        std::string path; // parent path and name joined with '/'
+        std::string name;
+        unsigned depth{0};
+        std::atomic<uint64_t> runs{0};
+        std::atomic<uint64_t> wallNs{0};
+        std::atomic<uint64_t> cpuNs{0};
+        std::atomic<uint64_t> rssDelta{0};
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::Count)> counters{};
+    };
+
+    static void enable();
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    static Stage *current();
+    static void count(Counter counter, uint64_t amount = 1);
+
+    // the table goes to stdout, the JSON to path
+    static void report();
+    static bool writeJson(const std::string &path);
+
+private:
+    friend class ProfileScope;
+
+    static Stage *stage(Stage *parent, std::string_view name);
+
+private:
+    static std::atomic<bool> s_enabled;
+    static std::mutex s_mutex;
+    static std::deque<Stage> s_stages; // in order of first use
+};
+
+// charges the calling thread's CPU time to a stage until destroyed; the
+// named form also times the stage and takes its peak RSS growth.
+// CPU time of nested scopes is only charged to the innermost one
+class ProfileScope
+{
+public:
+    explicit ProfileScope(std::string_view name);
+    explicit ProfileScope(Profiler::Stage *stage);
+    ~ProfileScope();
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    void enter();
+
+private:
+    Profiler::Stage *m_stage{nullptr};
+    Profiler::Stage *m_prev{nullptr};
+    uint64_t m_cpuStart{0};
+    uint64_t m_outerNested{0};
+    bool m_active{false};
+    bool m_timed{false};
+    std::chrono::steady_clock::time_point m_wallStart;
+    uint64_t m_peakStart{0};
+};
+
+#endif // PROFILER_H
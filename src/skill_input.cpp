@@ -2,21 +2,15 @@
 
 #include <algorithm>
 #include <cctype>
+#include <unordered_map>
 
 #define TOML_IMPLEMENTATION
 #include <toml++/toml.hpp>
 #include <fmt/format.h>
-#include <fmt/ostream.h>
-#include <regex>
 
 #include "skill_output.h"
-
-static std::string escQuote(const std::string &in)
-{
-    std::string out;
-    out = std::regex_replace(in, std::regex("\""), "\\\"");
-    return out;
-}
+#include "output_buffer.h"
+#include "string_kernels.h"
 
 MapLoc::Region getMapLocRegion(std::string_view name)
 {
@@ -37,13 +31,6 @@ MapLoc::Region getMapLocRegion(std::string_view name)
     return MapLoc::Region::Invalid;
 }
 
-bool validLocaleLabel(std::string_view locale)
-{
-    if(std::ranges::find(g_lcLabels, locale) == g_lcLabels.end())
-        return false;
-    return true;
-}
-
 std::optional<MapList> loadMapInput(toml::array *arr)
 {
     MapList mapList;
@@ -108,16 +95,14 @@ std::optional<LCLabel> loadAcquireInput(toml::table *tbl)
         return std::nullopt;
     for(auto &item : *tbl)
     {
-        if(std::ranges::find(g_lcOutLabels, item.first.str()) == g_lcOutLabels.end())
+        auto lc = parseOutLocale(item.first.str());
+        if(!lc)
             return std::nullopt;
 
-        std::string lc;
-        std::transform(item.first.begin(), item.first.end(), std::back_inserter(lc), ::tolower);
-
         auto descOpt = item.second.as_string();
         if(!descOpt)
             return std::nullopt;
-        input[lc] = escQuote(descOpt->get());
+        input[*lc] = escQuote(descOpt->get());
     }
     return input;
 }
@@ -218,7 +203,7 @@ bool loadSkillInput(toml::table *itemTable, Skill &skill)
                 return false;
             skill.acquireDesc = std::move(*acquire);
         }
-        else if(std::ranges::find(g_lcOutLabels, name) != g_lcOutLabels.end())
+        else if(auto lc = parseOutLocale(name); lc)
         {
             auto value = item.second.as_table();
             if(!value)
@@ -253,12 +238,11 @@ bool loadSkillInput(toml::table *itemTable, Skill &skill)
                 }
                 if(lclPtr)
                 {
-                    std::string lc;
-                    std::transform(name.begin(), name.end(), std::back_inserter(lc), ::tolower);
                     if(!lclPtr->has_value())
                         (*lclPtr) = std::make_optional<LCLabel>();
                     auto &lcl = *lclPtr;
-                    lcl->data.insert({lc, std::string{lblValue.value()}});
+                    if(!lcl->contains(*lc))
+                        (*lcl)[*lc] = lblValue.value();
                 }
             }
         }
@@ -310,14 +294,14 @@ bool loadSkillInputs(SkillLoader &loader, TravelInfo &info)
                 LCLabel tags;
                 for(auto &label : *labelTable)
                 {
-                    std::string locale = std::string{label.first.str()};
-                    std::transform(locale.begin(), locale.end(), locale.begin(), ::tolower);
-                    if(!validLocaleLabel(locale))
+                    auto locale = parseLocale(label.first.str());
+                    if(!locale)
                         return false;
                     auto tag = label.second.value<std::string>();
                     if(!tag)
                         return false;
-                    tags.data.insert({std::string{locale}, *tag});
+                    if(!tags.contains(*locale))
+                        tags[*locale] = *tag;
                 }
                 info.labelTags.insert({type, tags});
             }
@@ -332,42 +316,45 @@ bool mergeSkillInputs(TravelInfo &info,
     std::vector<Skill> xmlSkills = std::move(info.skills);
     info.skills = std::vector<Skill>{};
     info.skills.reserve(xmlSkills.size());
+
+    SkillIndex xmlIndex;
+    std::unordered_map<uint32_t, unsigned> lastInputLine;
+    for(const auto &[line, skillInput] : skillInputs)
+        lastInputLine[skillInput.id] = line;
+
     for(auto item = skillInputs.begin(); item != skillInputs.end(); ++item)
     {
         auto &skillInput = item->second;
         const uint32_t skillId = skillInput.id;
-        auto it = std::ranges::find(xmlSkills, skillId, &Skill::id);
-        if(it != xmlSkills.end())
-        {
-            auto mapIt = std::find_if(std::next(item), skillInputs.end(),
-                                      [skillId](auto &item)
-                { return item.second.id == skillId; });
-            if(mapIt == skillInputs.end())
-                it->status = Skill::SearchStatus::Found;
-            else
-                it->status = Skill::SearchStatus::MultiFound;
-            if(it->group == Skill::Type::Unknown)
-                it->group = skillInput.group;
-            it->race = skillInput.race;
-            it->storeLP = skillInput.storeLP;
-            it->minLevelInput = skillInput.minLevelInput;
-            it->mapList = skillInput.mapList;
-            it->acquireDesc = skillInput.acquireDesc;
-            it->overlapIds = skillInput.overlapIds;
-            it->sortLevel = skillInput.sortLevel;
-            it->label = skillInput.label;
-            it->zone = skillInput.zone;
-            it->zlabel = skillInput.zlabel;
-            it->detail = skillInput.detail;
-            it->tag = skillInput.tag;
-            it->skillTag = skillInput.skillTag;
-            // TODO: copy other skill input values
-
-            // ensure skillInput has a name
-            if(skillInput.nameId.empty())
-                skillInput.nameId = it->name.at(EN);
-        }
-        info.skills.push_back(std::move(*it));
+        Skill *skill = xmlIndex.find(xmlSkills, skillId);
+        if(!skill)
+            continue;
+
+        if(lastInputLine.at(skillId) == item->first)
+            skill->status = Skill::SearchStatus::Found;
+        else
+            skill->status = Skill::SearchStatus::MultiFound;
+        if(skill->group == Skill::Type::Unknown)
+            skill->group = skillInput.group;
+        skill->race = skillInput.race;
+        skill->storeLP = skillInput.storeLP;
+        skill->minLevelInput = skillInput.minLevelInput;
+        skill->mapList = skillInput.mapList;
+        skill->acquireDesc = skillInput.acquireDesc;
+        skill->overlapIds = skillInput.overlapIds;
+        skill->sortLevel = skillInput.sortLevel;
+        skill->label = skillInput.label;
+        skill->zone = skillInput.zone;
+        skill->zlabel = skillInput.zlabel;
+        skill->detail = skillInput.detail;
+        skill->tag = skillInput.tag;
+        skill->skillTag = skillInput.skillTag;
+        // TODO: copy other skill input values
+
+        // ensure skillInput has a name
+        if(skillInput.nameId.empty())
+            skillInput.nameId = skill->name.at(EN);
+        info.skills.push_back(std::move(*skill));
     }
 
     // TODO: verify overlaps against rep skills
@@ -486,7 +473,7 @@ void getNewSkills(TravelInfo &info)
 
 static std::string tomlLabelField(
         std::optional<std::reference_wrapper<const LCLabel>> labelsRef,
-        std::string_view locale,
+        Locale locale,
         std::string_view name,
         bool &comma)
 {
@@ -504,11 +491,9 @@ static std::string tomlLabelField(
     return ret;
 }
 
-static std::string tomlLabelFields(const Skill &skill, std::string_view locale)
+static std::string tomlLabelFields(const Skill &skill, Locale lc)
 {
     std::string ret;
-    std::string lc;
-    std::transform(locale.begin(), locale.end(), std::back_inserter(lc), ::tolower);
     if(skill.isNew)
     {
         ret = fmt::format("label=\"\", zone=\"\"");
@@ -540,63 +525,62 @@ static std::string tomlOverlapIds(const std::vector<uint32_t> &ids)
     return out;
 }
 
-static void addTomlSkill(std::ostream &out, const Skill &skill)
+static void addTomlSkill(OutputBuffer &out, const Skill &skill)
 {
     auto groupName = getGroupNameDefault(skill.group, Skill::Type::Rep);
-    fmt::println(out, "[[{}]]", groupName);
+    out.println("[[{}]]", groupName);
     if(skill.race.has_value())
-        fmt::println(out, "    race=\"{}\"", *skill.race);
-    fmt::println(out, "    id=\"0x{:08X}\"", skill.id);
+        out.println("    race=\"{}\"", *skill.race);
+    out.println("    id=\"0x{:08X}\"", skill.id);
     if(!skill.name.at(EN).empty())
-        fmt::println(out, "    name=\"{}\"", skill.name.at(EN));
+        out.println("    name=\"{}\"", skill.name.at(EN));
     else
-        fmt::println(out, "    name=\"{}\"", skill.nameId);
+        out.println("    name=\"{}\"", skill.nameId);
 
     if(skill.group != Skill::Type::Ignore)
     {
         if(skill.nameId != "Return to Camp" &&
                 skill.group != Skill::Type::Creep)
         {
-            for(auto lcIt = g_lcLabels.begin(); lcIt != g_lcLabels.end(); ++lcIt)
+            for(Locale lc : g_lcLabels)
             {
-                const std::string &lc = *lcIt;
-                fmt::println(out, "    {}={{{}}}", g_lcMap.at(lc), tomlLabelFields(skill, lc));
+                out.println("    {}={{{}}}", lcOutName(lc), tomlLabelFields(skill, lc));
             }
         }
         if(skill.skillTag.has_value())
-            fmt::println(out, "    tag=\"{}\"", *skill.skillTag);
-        fmt::println(out, "    map={}", tomlMapList(skill));
+            out.println("    tag=\"{}\"", *skill.skillTag);
+        out.println("    map={}", tomlMapList(skill));
         if(!skill.overlapIds.empty())
-            fmt::println(out, "    overlap=[{}]", tomlOverlapIds(skill.overlapIds));
+            out.println("    overlap=[{}]", tomlOverlapIds(skill.overlapIds));
         else if(skill.isNew && skill.isClass)
-            fmt::println(out, "    overlap=[]");
+            out.println("    overlap=[]");
         if(skill.storeLP)
-            fmt::println(out, "    store=true");
-        fmt::println(out, "    level={}",
+            out.println("    store=true");
+        out.println("    level={}",
                 skill.isNew ? fmt::format("{}", skill.minLevel) : skill.sortLevel);
 
         if(!skill.acquireDesc.empty())
         {
-            fmt::println(out, "    [{}.acquire_desc]", groupName);
-            for(auto lcIt = g_lcLabels.begin(); lcIt != g_lcLabels.end(); ++lcIt)
+            out.println("    [{}.acquire_desc]", groupName);
+            for(Locale lc : g_lcLabels)
             {
-                const std::string &lc = *lcIt;
-                fmt::println(out, "        {}=\"{}\"", g_lcMap.at(lc), skill.acquireDesc.at(lc));
+                out.println("        {}=\"{}\"", lcOutName(lc), skill.acquireDesc.at(lc));
             }
         }
     }
 }
 
-bool generateNewSkillInputFile(const TravelInfo &info)
+bool generateNewSkillInputFile(const TravelInfo &info, const std::string &path,
+                               OutputSummary &summary)
 {
-    std::ofstream out("skill_input.toml", std::ios::out | std::ios::binary);
-    fmt::println(out, "[labels]");
-    fmt::println(out, "    hunter={{EN=\"Guide\", DE=\"Führer\", FR=\"Guide\", ES=\"Guiar\", RU=\"Путь\" }}");
-    fmt::println(out, "    warden={{EN=\"Muster\", DE=\"Appell\", FR=\"Rassemblement\", ES=\"Reunión\", RU=\"Сбор\" }}");
-    fmt::println(out, "    mariner={{EN=\"Sail\", DE=\"Segeln\", FR=\"Naviguer\", ES=\"Navegar\", RU=\"Плаванье\" }}");
-    fmt::println(out, "    racials={{EN=\"Racial\", DE=\"Rasse\", FR=\"Race\", ES=\"Raza\", RU=\"Расовые\" }}");
-    fmt::println(out, "    rep={{EN=\"Rep\", DE=\"Ruf\", FR=\"Rep\", ES=\"Rep\", RU=\"Репутация\" }}");
-    fmt::println(out, "");
+    OutputBuffer out;
+    out.println("[labels]");
+    out.println("    hunter={{EN=\"Guide\", DE=\"Führer\", FR=\"Guide\", ES=\"Guiar\", RU=\"Путь\" }}");
+    out.println("    warden={{EN=\"Muster\", DE=\"Appell\", FR=\"Rassemblement\", ES=\"Reunión\", RU=\"Сбор\" }}");
+    out.println("    mariner={{EN=\"Sail\", DE=\"Segeln\", FR=\"Naviguer\", ES=\"Navegar\", RU=\"Плаванье\" }}");
+    out.println("    racials={{EN=\"Racial\", DE=\"Rasse\", FR=\"Race\", ES=\"Raza\", RU=\"Расовые\" }}");
+    out.println("    rep={{EN=\"Rep\", DE=\"Ruf\", FR=\"Rep\", ES=\"Rep\", RU=\"Репутация\" }}");
+    out.println("");
 
     auto lastType = Skill::Type::Unknown;
     for(auto &[line, skill] : info.inputs)
@@ -607,7 +591,7 @@ bool generateNewSkillInputFile(const TravelInfo &info)
             {
                 for(auto &skill : info.newSkills.at(lastType))
                 {
-                    fmt::println(out, "");
+                    out.println("");
                     addTomlSkill(out, skill);
                 }
             }
@@ -615,9 +599,8 @@ bool generateNewSkillInputFile(const TravelInfo &info)
         }
 
         if(line != info.inputs.begin()->first)
-            fmt::println(out, "");
+            out.println("");
         addTomlSkill(out, skill);
     }
-    out.flush();
-    return true;
+    return summary.write(path, out);
 }
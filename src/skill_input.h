@@ -4,11 +4,13 @@
 #include "skill_loader.h"
 
 class TravelInfo;
+class OutputSummary;
 bool loadSkillInputs(SkillLoader &loader, TravelInfo &info);
 bool mergeSkillInputs(TravelInfo &info,
                       std::map<unsigned, Skill> &skillInputs);
 
 void getNewSkills(TravelInfo &info);
-bool generateNewSkillInputFile(const TravelInfo &info);
+bool generateNewSkillInputFile(const TravelInfo &info, const std::string &path,
+                               OutputSummary &summary);
 
 #endif // SKILL_INPUT_H
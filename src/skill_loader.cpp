@@ -1,8 +1,14 @@
 #include "skill_loader.h"
+#include "item_stream.h"
+#include "task_graph.h"
+#include "profiler.h"
+#include "game_patterns.h"
+#include "string_kernels.h"
 
 #include <ranges>
 #include <unordered_map>
-#include <regex>
+#include <unordered_set>
+#include <set>
 #include <fmt/format.h>
 
 using namespace std;
@@ -19,32 +25,119 @@ Skill::Type getGroupTypeFromName(string_view name)
     return Skill::Type::Unknown;
 }
 
-static string fixXmlStr(string_view str)
+void SkillIndex::update(const std::vector<Skill> &skills)
 {
-    string buf;
-    auto out = back_inserter(buf);
-    std::regex quote("\\\\q");
-    std::regex_replace(out, str.begin(), str.end(), quote, "\\\"");
-    return buf;
+    {
+        shared_lock lock(m_mutex);
+        if(m_data == skills.data() && m_size == skills.size())
+            return;
+    }
+
+    unique_lock lock(m_mutex);
+    if(m_data == skills.data() && m_size == skills.size())
+        return;
+
+    m_data = skills.data();
+    m_size = skills.size();
+    m_ids.clear();
+    m_descKeys.clear();
+    m_ids.reserve(skills.size());
+    m_descKeys.reserve(skills.size());
+    for(size_t i = 0; i < skills.size(); ++i)
+    {
+        m_ids.emplace(skills[i].id, i);
+        m_descKeys.emplace(skills[i].descKey, i);
+    }
+}
+
+Skill *SkillIndex::find(std::vector<Skill> &skills, uint32_t id)
+{
+    Profiler::count(Profiler::Counter::Lookups);
+    update(skills);
+    shared_lock lock(m_mutex);
+    auto it = m_ids.find(id);
+    return it != m_ids.end() ? &skills[it->second] : nullptr;
 }
 
+Skill *SkillIndex::findDesc(std::vector<Skill> &skills, std::string_view descKey)
+{
+    Profiler::count(Profiler::Counter::Lookups);
+    update(skills);
+    shared_lock lock(m_mutex);
+    auto it = m_descKeys.find(descKey);
+    return it != m_descKeys.end() ? &skills[it->second] : nullptr;
+}
 
-SkillLoader::SkillLoader(std::string_view root, string_view twiiRoot) :
+void AcquireIndex::build(std::vector<Skill> &skills)
+{
+    m_data = skills.data();
+    m_size = skills.size();
+    m_items.clear();
+    for(auto &skill : skills)
+    {
+        for(auto &acquire : skill.acquire)
+            m_items[acquire.itemId].push_back({&skill, &acquire});
+    }
+}
+
+const std::vector<AcquireIndex::Entry> &AcquireIndex::find(std::vector<Skill> &skills,
+                                                           uint32_t itemId)
+{
+    static const std::vector<Entry> s_none;
+    Profiler::count(Profiler::Counter::Lookups);
+    if(m_data != skills.data() || m_size != skills.size())
+        build(skills);
+    auto it = m_items.find(itemId);
+    return it != m_items.end() ? it->second : s_none;
+}
+
+SkillLoader::SkillLoader(std::string_view root, string_view twiiRoot, unsigned jobs) :
     m_path(root),
-    m_twiiPath(twiiRoot) {}
+    m_twiiPath(twiiRoot),
+    m_pool(jobs) {}
+
+// runs func for every locale on the pool; each call only
+// writes its own locale's label slots
+bool SkillLoader::forEachLocale(const std::function<bool(Locale)> &func)
+{
+    std::array<std::future<bool>, LocaleCount> results;
+    for(size_t i = 0; i < LocaleCount; ++i)
+        results[i] = m_pool.submit([&func, lc = g_lcLabels[i]] { return func(lc); });
+
+    bool ok = true;
+    for(auto &result : results)
+        ok = m_pool.wait(result) && ok;
+    return ok;
+}
 
 std::string SkillLoader::getTwiiRoot() const
 {
     return fmt::format("{}/data/skill_input.toml", m_twiiPath);
 }
 
+std::string SkillLoader::lorePath(string_view file) const
+{
+    return fmt::format("{}\\lotro-data\\lore\\{}", m_path, file);
+}
+
+std::string SkillLoader::labelPath(Locale locale, string_view file) const
+{
+    return fmt::format("{}\\lotro-data\\lore\\labels\\{}\\{}", m_path, lcName(locale), file);
+}
+
+std::string SkillLoader::itemsPath() const
+{
+    return fmt::format("{}\\lotro-items-db\\items.xml", m_path);
+}
+
 std::vector<Skill> SkillLoader::getSkills()
 {
     string skillPath = fmt::format("{}\\lotro-data\\lore\\skills.xml", m_path);
-    if(!m_xml.load(skillPath))
+    XMLCache::Document xml = m_docs.load(skillPath);
+    if(!xml)
         return {};
 
-    xml_node<> *root = m_xml.doc().first_node("skills");
+    xml_node<> *root = xml->doc().first_node("skills");
     if(!root)
     {
         fmt::println("missing skills tag");
@@ -96,107 +189,108 @@ std::vector<Skill> SkillLoader::getSkills()
 
         skills.emplace_back(std::move(skill));
     }
+    m_docs.evict(skillPath);
 
-    getSkillNames(skills);
-    getSkillItems(skills);
-    getClassInfo(skills);
-    getQuests(skills);
-    getTraits(skills);
-    getAllegiance(skills);
+    // each stage waits on the stages whose fields it reads or
+    // overwrites; stage failures are not fatal here
+    m_skillIndex.update(skills);
+    TaskGraph stages;
+    auto items = stages.add("skill items", [&]
+    {
+        getSkillItems(skills);
+        m_acquireIndex.build(skills);
+        return true;
+    });
+    auto classes = stages.add("class info", [&] { getClassInfo(skills); return true; }, {items});
+    // quests may add acquire entries that traits maps to deeds
+    auto quests = stages.add("quests", [&] { getQuests(skills); return true; }, {items});
+    // deeds and allegiances overwrite minLevel after the class info
+    auto traits = stages.add("traits", [&] { getTraits(skills); return true; },
+                             {classes, quests});
+    stages.add("allegiances", [&] { getAllegiance(skills); return true; }, {traits});
+    stages.run(m_pool);
     return skills;
 }
 
-bool SkillLoader::getSkillNames(vector<Skill> &skills)
+static void disambiguateSkillNames(Locale locale, vector<Skill> &skills)
 {
-    for(const auto &lc : g_lcLabels)
+    // a skill needs a description when another skill
+    // with a different id shares its name
+    struct NameGroup
     {
-        if(!getSkillNames(lc, skills))
-            return false;
-    }
-
-    // NOTE: these steps are broken up since
-    //       some languages have different
-    //       sets of identical names
-    for(const auto &lc : g_lcLabels)
+        uint32_t id{0};
+        bool ambiguous{false};
+    };
+    auto localeName = [locale](const Skill &skill) -> string_view {
+        const string *name = skill.name.find(locale);
+        return name ? string_view{*name} : ""sv;
+    };
+
+    unordered_map<string_view, NameGroup> groups;
+    groups.reserve(skills.size());
+    for(const auto &skill : skills)
     {
-        if(!getSkillDesc(lc, skills))
-            return false;
-    }
-
-    return true;
-}
-
-bool SkillLoader::getSkillNames(const string &locale, vector<Skill> &skills)
-{
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\skills.xml", m_path, locale);
-    if(!m_xml.load(fp))
-        return false;
-
-    xml_node<> *root = m_xml.doc().first_node("labels");
-    if(!root)
-        return false;
-    xml_attribute<> *locAttr = root->first_attribute("locale");
-    if(!locAttr)
-        return false;
-    if(locAttr->value() != locale)
-        return false;
-
-    for(xml_node<> *node = root->first_node("label");
-            node; node = node->next_sibling("label"))
-    {
-        xml_attribute<> *attr = node->first_attribute("key");
-        if(!attr)
-            continue;
-
-        uint32_t key = atoi(attr->value());
-        auto it = std::ranges::find(skills, key, &Skill::id);
-        if(it == skills.end())
+        string_view name = localeName(skill);
+        if(name.empty())
             continue;
 
-        auto &skill = *it;
-        attr = node->first_attribute("value");
-        if(attr)
-            skill.name[locale] = fixXmlStr(attr->value());
+        auto [it, inserted] = groups.try_emplace(name, NameGroup{skill.id});
+        if(!inserted && it->second.id != skill.id)
+            it->second.ambiguous = true;
     }
 
-    // disambiguate identical skill names
     for(auto &skill : skills)
     {
         if(skill.desc)
             continue;
 
-        auto it = std::ranges::find_if(skills, [&](auto &s) {
-            return skill.id != s.id &&
-                   skill.name[locale] != "" &&
-                   skill.name[locale] == s.name[locale];
-        });
-
-        if(it == skills.end())
+        string_view name = localeName(skill);
+        if(name.empty())
             continue;
 
-        if(!it->desc)
-        {
-            it->desc = std::make_optional<LCLabel>();
-        }
-        skill.desc = std::make_optional<LCLabel>();
+        if(groups.at(name).ambiguous)
+            skill.desc = std::make_optional<LCLabel>();
     }
+}
+
+bool SkillLoader::getSkillNames(vector<Skill> &skills)
+{
+    // description candidates per skill; only kept for
+    // skills whose names turn out to be ambiguous
+    vector<LCLabel> descs(skills.size());
+    m_skillIndex.update(skills);
+    if(!forEachLocale([&](Locale lc) { return getSkillLabels(lc, skills, descs); }))
+        return false;
 
+    // NOTE: these steps are broken up since
+    //       some languages have different
+    //       sets of identical names
+    for(Locale lc : g_lcLabels)
+        disambiguateSkillNames(lc, skills);
+
+    for(size_t i = 0; i < skills.size(); ++i)
+    {
+        if(skills[i].desc)
+            skills[i].desc = std::move(descs[i]);
+    }
     return true;
 }
 
-bool SkillLoader::getSkillDesc(const string &locale, vector<Skill> &skills)
+bool SkillLoader::getSkillLabels(Locale locale, vector<Skill> &skills,
+                                 vector<LCLabel> &descs)
 {
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\skills.xml", m_path, locale);
-    if(!m_xml.load(fp))
+    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\skills.xml", m_path, lcName(locale));
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("labels");
+    xml_node<> *root = xml->doc().first_node("labels");
     if(!root)
         return false;
     xml_attribute<> *locAttr = root->first_attribute("locale");
     if(!locAttr)
         return false;
-    if(locAttr->value() != locale)
+    if(locAttr->value() != lcName(locale))
         return false;
 
     for(xml_node<> *node = root->first_node("label");
@@ -207,24 +301,24 @@ bool SkillLoader::getSkillDesc(const string &locale, vector<Skill> &skills)
             continue;
 
         std::string_view key = attr->value();
-        auto it = std::ranges::find(skills, key, &Skill::descKey);
-        if(it == skills.end())
-            continue;
-
-        auto &skill = *it;
-        if(!skill.desc)
-            continue;
-
-        attr = node->first_attribute("value");
-        if(!attr)
-            continue;
-
-        (*skill.desc)[locale] = fixXmlStr(attr->value());
+        xml_attribute<> *valueAttr = node->first_attribute("value");
+        if(Skill *skill = m_skillIndex.find(skills, atoi(key.data())); skill)
+        {
+            if(valueAttr)
+                skill->name[locale] = fixXmlStr(valueAttr->value());
+        }
+        if(Skill *skill = m_skillIndex.findDesc(skills, key); skill)
+        {
+            if(valueAttr)
+                descs[skill - skills.data()][locale] = fixXmlStr(valueAttr->value());
+        }
     }
+    m_docs.evict(fp);
     return true;
 }
 
-static void loadClassSkillInfo(xml_node<> *root, std::vector<Skill> &skills)
+static void loadClassSkillInfo(xml_node<> *root, std::vector<Skill> &skills,
+                               SkillIndex &index)
 {
     for(xml_node<> *node = root->first_node("classSkill");
             node; node = node->next_sibling("classSkill"))
@@ -233,8 +327,8 @@ static void loadClassSkillInfo(xml_node<> *root, std::vector<Skill> &skills)
         if(!attr)
             continue;
         uint32_t skillId = atoi(attr->value());
-        auto it = ranges::find(skills, skillId, &Skill::id);
-        if(it == skills.end())
+        Skill *skill = index.find(skills, skillId);
+        if(!skill)
             continue;
         attr = node->first_attribute("minLevel");
         if(!attr)
@@ -242,18 +336,19 @@ static void loadClassSkillInfo(xml_node<> *root, std::vector<Skill> &skills)
         unsigned minLevel = atoi(attr->value());
         if(!minLevel)
             continue;
-        it->minLevel = minLevel;
-        it->autoLevel = true;
+        skill->minLevel = minLevel;
+        skill->autoLevel = true;
     }
 }
 
 bool SkillLoader::getClassInfo(std::vector<Skill> &skills)
 {
     string skillPath = fmt::format("{}\\lotro-data\\lore\\classes.xml", m_path);
-    if(!m_xml.load(skillPath))
+    XMLCache::Document xml = m_docs.load(skillPath);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("classes");
+    xml_node<> *root = xml->doc().first_node("classes");
     if(!root)
     {
         return false;
@@ -270,12 +365,58 @@ bool SkillLoader::getClassInfo(std::vector<Skill> &skills)
                 attr->value() == "Warden"sv ||
                 attr->value() == "Corsair"sv)
         {
-            loadClassSkillInfo(node, skills);
+            loadClassSkillInfo(node, skills, m_skillIndex);
         }
     }
+    m_docs.evict(skillPath);
     return true;
 }
 
+static void addSkillItem(const ItemRecord &record, Skill &skill)
+{
+    const char *attr = record.item.get("key");
+    Acquire acquire;
+    acquire.itemId = atoi(attr);
+    if(attr = record.item.get("valueTableId"); attr)
+        acquire.valueTableId = atoi(attr);
+    if(attr = record.item.get("level"); attr)
+        acquire.level = atoi(attr);
+    if(attr = record.item.get("quality"); attr)
+        acquire.quality = attr;
+    skill.acquire.push_back(acquire);
+
+    if(attr = record.item.get("minLevel"); attr)
+        skill.minLevel = atoi(attr);
+    if(attr = record.item.get("requiredClass"); attr)
+    {
+        skill.group = getGroupTypeFromName(attr);
+        if(skill.group != Skill::Type::Unknown)
+            skill.isClass = true;
+    }
+    if(attr = record.item.get("requiredFaction"); attr)
+    {
+        unsigned i = 0;
+        string_view words{attr};
+        for(const auto word : std::ranges::split_view(words, ";"sv))
+        {
+            switch(i)
+            {
+            case 0: skill.factionId = atoi(word.data()); break;
+            case 1: skill.factionRank = atoi(word.data()); break;
+            default: break;
+            }
+            ++i;
+        }
+    }
+    if(skill.group == Skill::Type::Unknown)
+    {
+        if(skill.cat == SkillCategory::Creep)
+        {
+            skill.group = Skill::Type::Creep;
+        }
+    }
+}
+
 // <item key="1879501345" name="Muster at Utug-bûr" icon="1090531744-1090519043-1090531745" level="5" category="ITEM" class="105" binding="BIND_ON_ACQUIRE" unique="true"
 //   quality="RARE" minLevel="140" requiredClass="Warden" requiredFaction="1879489736;3" description="key:621104289:54354734" valueTableId="1879094316">
 // <stats/>
@@ -284,97 +425,92 @@ bool SkillLoader::getClassInfo(std::vector<Skill> &skills)
 // </item>
 bool SkillLoader::getSkillItems(std::vector<Skill> &skills)
 {
+    struct SkillItem
+    {
+        Skill *skill;
+        ItemRecord record;
+    };
+    struct Chunk
+    {
+        std::vector<SkillItem> items;
+        uint64_t bytesRead{0};
+        uint64_t bytesSkipped{0};
+        size_t itemsSkipped{0};
+        bool ok{false};
+    };
+
+    // chunks are parsed and filtered in parallel, then applied
+    // in document order since later items overwrite skill fields
     string fp = fmt::format("{}\\lotro-items-db\\items.xml", m_path);
-    if(!m_xml.load(fp))
-        return false;
-
-    xml_node<> *root = m_xml.doc().first_node("items");
-    if(!root)
+    auto ranges = ItemStream::split(fp, max(1u, m_pool.size()));
+    if(ranges.empty())
         return false;
 
-    for(xml_node<> *node = root->first_node("item");
-            node; node = node->next_sibling("item"))
+    m_skillIndex.update(skills);
+    auto parseChunk = [&](ItemRange range)
     {
-        xml_attribute<> *attr = node->first_attribute("key");
-        if(!attr)
-            continue;
-
-        std::string_view itemKey = attr->value();
-        // TODO: capture other attr values
-        xml_node<> *grants = node->first_node("grants");
-        if(!grants)
-            continue;
-
-        attr = grants->first_attribute("id");
-        if(!attr)
-            continue;
-        uint32_t key = atoi(attr->value());
-        auto it = std::ranges::find(skills, key, &Skill::id);
-        if(it == skills.end())
-            continue;
-
-        auto &skill = *it;
-        Acquire acquire;
-        acquire.itemId = atoi(itemKey.data());
-        if(attr = node->first_attribute("valueTableId"); attr)
-            acquire.valueTableId = atoi(attr->value());
-        if(attr = node->first_attribute("level"); attr)
-            acquire.level = atoi(attr->value());
-        if(attr = node->first_attribute("quality"); attr)
-            acquire.quality = attr->value();
-        skill.acquire.push_back(acquire);
+        Chunk chunk;
+        ItemStream stream;
+        if(!stream.open(fp, range))
+            return chunk;
 
-        if(attr = node->first_attribute("minLevel"); attr)
-            skill.minLevel = atoi(attr->value());
-        if(attr = node->first_attribute("requiredClass"); attr)
-        {
-            skill.group = getGroupTypeFromName(attr->value());
-            if(skill.group != Skill::Type::Unknown)
-                skill.isClass = true;
-        }
-        if(attr = node->first_attribute("requiredFaction"); attr)
-        {
-            unsigned i = 0;
-            string_view words{attr->value()};
-            for(const auto word : std::ranges::split_view(words, ";"sv))
-            {
-                switch(i)
-                {
-                case 0: skill.factionId = atoi(word.data()); break;
-                case 1: skill.factionRank = atoi(word.data()); break;
-                default: break;
-                }
-                ++i;
-            }
-        }
-        if(skill.group == Skill::Type::Unknown)
+        ItemRecord record;
+        while(stream.next(record))
         {
-            if(skill.cat == SkillCategory::Creep)
-            {
-                skill.group = Skill::Type::Creep;
-            }
+            if(!record.item.get("key"))
+                continue;
+            // TODO: capture other attr values
+            const char *attr = record.grants.get("id");
+            if(!attr)
+                continue;
+            Skill *skill = m_skillIndex.find(skills, atoi(attr));
+            if(!skill)
+                continue;
+            chunk.items.push_back({skill, record});
         }
+        chunk.bytesRead = stream.bytesRead();
+        chunk.bytesSkipped = stream.bytesSkipped();
+        chunk.itemsSkipped = stream.itemsSkipped();
+        chunk.ok = !stream.error();
+        return chunk;
+    };
+
+    std::vector<std::future<Chunk>> chunks;
+    for(const auto &range : ranges)
+        chunks.push_back(m_pool.submit([&parseChunk, range] { return parseChunk(range); }));
+
+    bool ok = true;
+    uint64_t bytesRead = 0;
+    uint64_t bytesSkipped = 0;
+    size_t itemsSkipped = 0;
+    for(auto &result : chunks)
+    {
+        Chunk chunk = m_pool.wait(result);
+        for(const auto &item : chunk.items)
+            addSkillItem(item.record, *item.skill);
+        bytesRead += chunk.bytesRead;
+        bytesSkipped += chunk.bytesSkipped;
+        itemsSkipped += chunk.itemsSkipped;
+        ok = chunk.ok && ok;
     }
-    return true;
+    fmt::println("ITEMS: skipped {} items without grants ({} of {} bytes)",
+                 itemsSkipped, bytesSkipped, bytesRead);
+    return ok;
 }
 
 bool SkillLoader::getFactionLabels(TravelInfo &info)
 {
-    for(const auto &lc : g_lcLabels)
-    {
-        if(!getFactionLabel(lc, info))
-            return false;
-    }
-    return true;
+    return forEachLocale([&](Locale lc) { return getFactionLabel(lc, info); });
 }
 
-bool SkillLoader::getFactionLabel(const std::string &locale, TravelInfo &info)
+bool SkillLoader::getFactionLabel(Locale locale, TravelInfo &info)
 {
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\factions.xml", m_path, locale);
-    if(!m_xml.load(fp))
+    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\factions.xml", m_path, lcName(locale));
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("labels");
+    xml_node<> *root = xml->doc().first_node("labels");
     if(!root)
         return false;
 
@@ -405,8 +541,7 @@ bool SkillLoader::getFactionLabel(const std::string &locale, TravelInfo &info)
         else
         {
             uint32_t factionId = atoi(key.data());
-            auto it = ranges::find(info.factions, factionId, &Faction::id);
-            if(it != info.factions.end())
+            if(Faction *faction = info.findFaction(factionId))
             {
                 string_view factionName = attr->value();
                 if(!factionName.empty() && factionName.back() == ']')
@@ -414,10 +549,11 @@ bool SkillLoader::getFactionLabel(const std::string &locale, TravelInfo &info)
                     // remove in-game output transformation hints
                     factionName = {factionName.data(), factionName.find_last_of('[')};
                 }
-                it->name[locale] = factionName;
+                faction->name[locale] = factionName;
             }
         }
     }
+    m_docs.evict(fp);
     return true;
 }
 
@@ -434,13 +570,22 @@ bool SkillLoader::getFactionLabel(const std::string &locale, TravelInfo &info)
 bool SkillLoader::getFactions(TravelInfo &info)
 {
     string fp = fmt::format("{}\\lotro-data\\lore\\factions.xml", m_path);
-    if(!m_xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("factions");
+    xml_node<> *root = xml->doc().first_node("factions");
     if(!root)
         return false;
 
+    unordered_set<uint32_t> skillFactions;
+    set<pair<uint32_t, unsigned>> skillRanks;
+    for(const auto &skill : info.skills)
+    {
+        skillFactions.insert(skill.factionId);
+        skillRanks.insert({skill.factionId, skill.factionRank});
+    }
+
     for(xml_node<> *node = root->first_node("faction");
             node; node = node->next_sibling("faction"))
     {
@@ -451,8 +596,7 @@ bool SkillLoader::getFactions(TravelInfo &info)
         Faction faction;
         string_view factionId = attr->value();
         faction.id = atoi(factionId.data());
-        auto skillIt = std::ranges::find(info.skills, faction.id, &Skill::factionId);
-        if(skillIt == info.skills.end())
+        if(!skillFactions.contains(faction.id))
             continue;
 
         for(xml_node<> *level = node->first_node("level");
@@ -469,44 +613,30 @@ bool SkillLoader::getFactions(TravelInfo &info)
             faction.ranks.insert({rank, labelKey});
 
             auto it = ranges::find(info.repRanks, labelKey, &RepRank::key);
-            if(it == info.repRanks.end())
+            if(it == info.repRanks.end() && skillRanks.contains({faction.id, rank}))
             {
-                for(auto &skill : info.skills)
-                {
-                    if(skill.factionId == faction.id && skill.factionRank == rank)
-                    {
-                        info.repRanks.push_back(RepRank{labelKey, {}});
-                        break;
-                    }
-                }
+                info.repRanks.push_back(RepRank{labelKey, {}});
             }
         }
         info.factions.push_back(faction);
     }
-
-    if(!getFactionLabels(info))
-        return false;
-
+    m_docs.evict(fp);
     return true;
 }
 
 bool SkillLoader::getCurrencyLabels(TravelInfo &info)
 {
-    for(const auto &lc : g_lcLabels)
-    {
-        if(!getCurrencyLabel(lc, info))
-            return false;
-    }
-    return true;
+    return forEachLocale([&](Locale lc) { return getCurrencyLabel(lc, info); });
 }
 
-bool SkillLoader::getCurrencyLabel(const string &locale, TravelInfo &info)
+bool SkillLoader::getCurrencyLabel(Locale locale, TravelInfo &info)
 {
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\items.xml", m_path, locale);
-    if(!m_xml.load(fp))
+    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\items.xml", m_path, lcName(locale));
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("labels");
+    xml_node<> *root = xml->doc().first_node("labels");
     if(!root)
         return false;
 
@@ -524,12 +654,12 @@ bool SkillLoader::getCurrencyLabel(const string &locale, TravelInfo &info)
             continue;
 
         uint32_t tokenId = atoi(key.data());
-        auto tokenIt = ranges::find(info.currencies, tokenId, &Currency::id);
-        if(tokenIt != info.currencies.end())
+        if(Currency *currency = info.findCurrency(tokenId))
         {
-            tokenIt->name[locale] = attr->value();
+            currency->name[locale] = attr->value();
         }
     }
+    m_docs.evict(fp);
     return true;
 }
 
@@ -537,65 +667,73 @@ bool SkillLoader::getCurrencyLabel(const string &locale, TravelInfo &info)
 bool SkillLoader::getCurrencies(TravelInfo &info)
 {
     info.currencies.push_back({1879255991}); // Mithril Coins
-    if(!getBarters(info))
-        return false;
-
-    if(!getVendors(info))
-        return false;
 
-    if(!getNPCTitleKeys(info))
-        return false;
-
-    if(!getNPCLabels(info))
+    // barters add the currencies and barter deeds; vendors
+    // add the remaining NPCs whose titles are then resolved
+    TaskGraph stages;
+    auto barters = stages.add("barters", [&] { return getBarters(info); });
+    auto vendors = stages.add("vendors", [&] { return getVendors(info); }, {barters});
+    stages.add("NPC titles", [&] { return getNPCTitleKeys(info); }, {vendors});
+    stages.add("barter deed labels", [&]
+    {
+        getDeedLabels(info.skills, [](Skill &skill)
+                { return skill.barterDeed ? &skill.barterDeed.value() : nullptr; });
+        return true;
+    }, {barters});
+    if(!stages.run(m_pool))
         return false;
 
-    if(!getCurrencyLabels(info))
-       return false;
-
-    getDeedLabels(info.skills, [](Skill &skill)
-            { return skill.barterDeed ? &skill.barterDeed.value() : nullptr; });
+    // deeds are shared with getTraits and not read by any later stage
+    m_docs.evict(fmt::format("{}\\lotro-data\\lore\\deeds.xml", m_path));
+    for(Locale lc : g_lcLabels)
+    {
+        m_docs.evict(fmt::format("{}\\lotro-data\\lore\\labels\\{}\\deeds.xml", m_path, lcName(lc)));
+    }
     return true;
 }
 
-static vector<uint32_t> getBartererId(xml_node<> *root, xml_node<> *proNode)
+// barterers that offer each barterProfile, in document order
+static BartererIds getBartererIds(xml_node<> *root)
 {
-    // now that barterEntries have been parsed
-    // get the profileId for the barterProfile
-    // and search through barterer starting from root
-    vector<uint32_t> barterIds;
-    xml_attribute<> *attr = proNode->first_attribute("profileId");
-    if(!attr)
-        return barterIds;
-    const uint32_t profileId = atoi(attr->value());
+    BartererIds barterIds;
     for(xml_node<> *brtrNode = root->first_node("barterer");
             brtrNode; brtrNode = brtrNode->next_sibling("barterer"))
     {
+        xml_attribute<> *idAttr = brtrNode->first_attribute("id");
+        if(!idAttr)
+            continue;
+        uint32_t barterId = atoi(idAttr->value());
         for(xml_node<> *bpNode = brtrNode->first_node("barterProfile");
                 bpNode; bpNode = bpNode->next_sibling("barterProfile"))
         {
-            attr = bpNode->first_attribute("profileId");
-            if(!attr)
-                continue;
-            uint32_t matchProId = atoi(attr->value());
-            if(matchProId != profileId)
-                continue;
-            attr = brtrNode->first_attribute("id");
+            xml_attribute<> *attr = bpNode->first_attribute("profileId");
             if(!attr)
                 continue;
-            barterIds.push_back(atoi(attr->value()));
+            barterIds[atoi(attr->value())].push_back(barterId);
         }
     }
     return barterIds;
 }
 
+static const vector<uint32_t> &getBartererId(const BartererIds &barterIds,
+                                             xml_node<> *proNode)
+{
+    static const vector<uint32_t> s_none;
+    xml_attribute<> *attr = proNode->first_attribute("profileId");
+    if(!attr)
+        return s_none;
+    auto it = barterIds.find(atoi(attr->value()));
+    return it != barterIds.end() ? it->second : s_none;
+}
+
 std::optional<Deed> SkillLoader::getBarterRequiredDeed(uint32_t reqDeedId)
 {
-    XMLLoader xml;
     string fp = fmt::format("{}\\lotro-data\\lore\\deeds.xml", m_path);
-    if(!xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return nullopt;
 
-    xml_node<> *root = xml.doc().first_node("deeds");
+    xml_node<> *root = xml->doc().first_node("deeds");
     if(!root)
         return nullopt;
     for(xml_node<> *node = root->first_node("deed");
@@ -629,7 +767,7 @@ void SkillLoader::addRequiredDeed(string_view questKey, Skill &skill)
         if(skill.barterDeed->id != deedId)
         {
             fmt::println("BARTER: DEED ALREADY SET {}({}): {} : {}",
-                         skill.name[EN], skill.id, skill.barterDeed->id,
+                         skill.name.at(EN), skill.id, skill.barterDeed->id,
                          deedId);
         }
     }
@@ -663,7 +801,7 @@ void SkillLoader::addRequiredFaction(string_view factionKey, Skill &skill)
         if(skill.factionId != factionId)
         {
             fmt::println("BARTER: FACTION ALREADY SET {}({}): {} : {}",
-                         skill.name[EN], skill.id, skill.factionId,
+                         skill.name.at(EN), skill.id, skill.factionId,
                          factionId);
         }
         else if(factionRank > skill.factionRank)
@@ -678,7 +816,8 @@ void SkillLoader::addRequiredFaction(string_view factionKey, Skill &skill)
     }
 }
 
-void SkillLoader::parseBarterRequired(xml_node<> *root, xml_node<> *proNode, TravelInfo &info)
+void SkillLoader::parseBarterRequired(const BartererIds &barterIds,
+                                      xml_node<> *proNode, TravelInfo &info)
 {
     string_view factionKey;
     string_view questKey;
@@ -699,16 +838,12 @@ void SkillLoader::parseBarterRequired(xml_node<> *root, xml_node<> *proNode, Tra
             if(!recvAttr)
                 continue;
             uint32_t itemId = atoi(recvAttr->value());
-            std::vector<Acquire>::iterator acquireIt{};
-            auto skillIt = ranges::find_if(info.skills, [&acquireIt, itemId](auto &skill)
-            {
-                acquireIt = ranges::find(skill.acquire, itemId, &Acquire::itemId);
-                return acquireIt != skill.acquire.end();
-            });
-            if(skillIt == info.skills.end())
+            auto &acquires = m_acquireIndex.find(info.skills, itemId);
+            if(acquires.empty())
             {
                 continue;
             }
+            auto [skill, acquire] = acquires.front();
             for(xml_node<> *giveNode = brtrNode->first_node("give");
                  giveNode; giveNode = giveNode->next_sibling("give"))
             {
@@ -725,33 +860,31 @@ void SkillLoader::parseBarterRequired(xml_node<> *root, xml_node<> *proNode, Tra
                     token.amt = atoi(giveAttr->value());
                 }
 
-                auto barterIds = getBartererId(root, proNode);
-                if(barterIds.empty())
+                auto &profileBarterIds = getBartererId(barterIds, proNode);
+                if(profileBarterIds.empty())
                 {
-                    fmt::println("BARTER: NONE FOUND {}", skillIt->id);
+                    fmt::println("BARTER: NONE FOUND {}", skill->id);
                 }
-                for(auto barterId : barterIds)
+                for(auto barterId : profileBarterIds)
                 {
                     Barter barter{barterId};
-                    auto npcIt = ranges::find(info.npcs, barterId, &NPC::id);
-                    if(npcIt == info.npcs.end())
+                    if(!info.findNPC(barterId))
                     {
                         info.npcs.push_back({barterId});
                     }
                     barter.currency.push_back(token);
-                    acquireIt->barters.push_back(barter);
+                    acquire->barters.push_back(barter);
                 }
 
-                auto tokenIt = ranges::find(info.currencies, token.id, &Currency::id);
-                if(tokenIt == info.currencies.end())
+                if(!info.findCurrency(token.id))
                 {
                     info.currencies.push_back({token.id});
                 }
 
                 if(!factionKey.empty())
-                    addRequiredFaction(factionKey, *skillIt);
+                    addRequiredFaction(factionKey, *skill);
                 if(!questKey.empty())
-                    addRequiredDeed(questKey, *skillIt);
+                    addRequiredDeed(questKey, *skill);
             }
         }
     }
@@ -768,19 +901,22 @@ void SkillLoader::parseBarterRequired(xml_node<> *root, xml_node<> *proNode, Tra
 bool SkillLoader::getBarters(TravelInfo &info)
 {
     string fp = fmt::format("{}\\lotro-data\\lore\\barters.xml", m_path);
-    if(!m_xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("barterers");
+    xml_node<> *root = xml->doc().first_node("barterers");
     if(!root)
         return false;
 
     info.currencies.reserve(300);
+    const BartererIds barterIds = getBartererIds(root);
     for(xml_node<> *proNode = root->first_node("barterProfile");
             proNode; proNode = proNode->next_sibling("barterProfile"))
     {
-        parseBarterRequired(root, proNode, info);
+        parseBarterRequired(barterIds, proNode, info);
     }
+    m_docs.evict(fp);
     return true;
 }
 
@@ -793,10 +929,11 @@ bool SkillLoader::getBarters(TravelInfo &info)
 bool SkillLoader::getNPCTitleKeys(TravelInfo &info)
 {
     string fp = fmt::format("{}\\lotro-data\\lore\\NPCs.xml", m_path);
-    if(!m_xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("NPCs");
+    xml_node<> *root = xml->doc().first_node("NPCs");
     if(!root)
         return false;
     for(xml_node<> *node = root->first_node("NPC");
@@ -809,36 +946,33 @@ bool SkillLoader::getNPCTitleKeys(TravelInfo &info)
         if(!npcId)
             return false;
 
-        auto it = ranges::find(info.npcs, npcId, &NPC::id);
-        if(it != info.npcs.end())
+        if(NPC *npc = info.findNPC(npcId))
         {
             attr = node->first_attribute("title");
             if(attr)
             {
-                it->titleKey = attr->value();
+                npc->titleKey = attr->value();
             }
         }
     }
+    info.npcTitleKeys.invalidate();
+    m_docs.evict(fp);
     return true;
 }
 
 bool SkillLoader::getNPCLabels(TravelInfo &info)
 {
-    for(const auto &lc : g_lcLabels)
-    {
-        if(!getNPCLabel(lc, info))
-            return false;
-    }
-    return true;
+    return forEachLocale([&](Locale lc) { return getNPCLabel(lc, info); });
 }
 
-bool SkillLoader::getNPCLabel(const std::string &locale, TravelInfo &info)
+bool SkillLoader::getNPCLabel(Locale locale, TravelInfo &info)
 {
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\npc.xml", m_path, locale);
-    if(!m_xml.load(fp))
+    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\npc.xml", m_path, lcName(locale));
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("labels");
+    xml_node<> *root = xml->doc().first_node("labels");
     if(!root)
         return false;
 
@@ -852,70 +986,88 @@ bool SkillLoader::getNPCLabel(const std::string &locale, TravelInfo &info)
         string_view key = attr->value();
         if(key.starts_with("key"))
         {
-            auto it = ranges::find(info.npcs, key, &NPC::titleKey);
-            if(it != info.npcs.end())
+            if(NPC *npc = info.findNPCTitle(key))
             {
                 attr = node->first_attribute("value");
                 if(attr)
                 {
-                    it->title[locale] = fixXmlStr(attr->value());
+                    npc->title[locale] = fixXmlStr(attr->value());
                 }
             }
         }
         else
         {
             uint32_t npcId = atoi(attr->value());
-            auto it = ranges::find(info.npcs, npcId, &NPC::id);
-            if(it != info.npcs.end())
+            if(NPC *npc = info.findNPC(npcId))
             {
                 attr = node->first_attribute("value");
                 if(attr)
                 {
-                    it->name[locale] = fixXmlStr(attr->value());
+                    npc->name[locale] = fixXmlStr(attr->value());
                 }
             }
         }
     }
+    m_docs.evict(fp);
     return true;
 }
 
-static Barter *getVendorInfo(string_view sellListId, xml_node<> *root, Acquire &acquire)
+struct VendorSellList
 {
+    uint32_t vendorId{0};
+    double sellFactor{0};
+};
+using VendorSellLists = unordered_map<string_view, VendorSellList>;
+
+// the first vendor with both an id and a sellFactor owns a sellList
+static VendorSellLists getVendorSellLists(xml_node<> *root)
+{
+    VendorSellLists sellLists;
     for(xml_node<> *node = root->first_node("vendor");
             node; node = node->next_sibling("vendor"))
     {
+        xml_attribute<> *attr = node->first_attribute("id");
+        if(!attr)
+            continue;
+        uint32_t vendorId = atoi(attr->value());
+        attr = node->first_attribute("sellFactor");
+        if(!attr)
+            continue;
+        double sellFactor = atof(attr->value());
         for(xml_node<> *sellNode = node->first_node("sellList");
                 sellNode; sellNode = sellNode->next_sibling("sellList"))
         {
-            xml_attribute<> *attr = sellNode->first_attribute("sellListId");
+            attr = sellNode->first_attribute("sellListId");
             if(!attr)
                 continue;
-            string_view sellId = attr->value();
-            if(sellListId == sellId)
-            {
-                attr = node->first_attribute("id");
-                if(!attr)
-                    continue;
-                uint32_t vendorId = atoi(attr->value());
-                attr = node->first_attribute("sellFactor");
-                if(!attr)
-                    continue;
-                acquire.barters.push_back({vendorId, atof(attr->value())});
-                return &acquire.barters.back();
-            }
+            sellLists.try_emplace(attr->value(), VendorSellList{vendorId, sellFactor});
         }
     }
-    return nullptr;
+    return sellLists;
 }
 
-uint32_t SkillLoader::getValueTableValue(const Acquire &item)
+static Barter *getVendorInfo(string_view sellListId, const VendorSellLists &sellLists,
+                             Acquire &acquire)
 {
-    XMLLoader xml;
+    auto it = sellLists.find(sellListId);
+    if(it == sellLists.end())
+        return nullptr;
+    acquire.barters.push_back({it->second.vendorId, it->second.sellFactor});
+    return &acquire.barters.back();
+}
+
+bool SkillLoader::getValueTables()
+{
+    lock_guard lock(m_valueTablesMutex);
+    if(!m_valueTables.empty())
+        return true;
+
     string fp = fmt::format("{}\\lotro-data\\lore\\valueTables.xml", m_path);
-    if(!xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = xml.doc().first_node("valueTables");
+    xml_node<> *root = xml->doc().first_node("valueTables");
     if(!root)
         return false;
     for(xml_node<> *node = root->first_node("valueTable");
@@ -925,23 +1077,16 @@ uint32_t SkillLoader::getValueTableValue(const Acquire &item)
         if(!attr)
             continue;
         uint32_t id = atoi(attr->value());
-        if(id != item.valueTableId)
-            continue;
-        double factor = 0;
+        ValueTable &table = m_valueTables[id].emplace_back();
         for(xml_node<> *quality = node->first_node("quality");
                 quality; quality = quality->next_sibling("quality"))
         {
             attr = quality->first_attribute("key");
             if(!attr)
                 continue;
-            string_view key = attr->value();
-            if(key == item.quality)
-            {
-                attr = quality->first_attribute("factor");
-                if(attr)
-                    factor = atof(attr->value());
-                break;
-            }
+            string key = attr->value();
+            attr = quality->first_attribute("factor");
+            table.factors.try_emplace(std::move(key), attr ? atof(attr->value()) : 0);
         }
         for(xml_node<> *base = node->first_node("baseValue");
                 base; base = base->next_sibling("baseValue"))
@@ -950,27 +1095,48 @@ uint32_t SkillLoader::getValueTableValue(const Acquire &item)
             if(!attr)
                 continue;
             uint32_t level = atoi(attr->value());
-            if(level == item.level)
-            {
-                attr = base->first_attribute("value");
-                if(attr)
-                    return factor * atof(attr->value());
-                return 0;
-            }
+            attr = base->first_attribute("value");
+            table.baseValues.try_emplace(level, attr ? atof(attr->value()) : 0);
         }
     }
+    m_docs.evict(fp);
+    return true;
+}
+
+uint32_t SkillLoader::getValueTableValue(const Acquire &item) const
+{
+    auto it = m_valueTables.find(item.valueTableId);
+    if(it == m_valueTables.end())
+        return 0;
+
+    for(const auto &table : it->second)
+    {
+        auto base = table.baseValues.find(item.level);
+        if(base == table.baseValues.end())
+            continue;
+        auto factor = table.factors.find(item.quality);
+        if(factor == table.factors.end())
+            return 0;
+        return factor->second * base->second;
+    }
     return 0;
 }
 
 bool SkillLoader::getVendors(TravelInfo &info)
 {
+    // without value tables vendors are still emitted, with a buyAmt of 0
+    if(!getValueTables())
+        fmt::println("VENDORS: failed to load valueTables.xml, buyAmt will be 0");
+
     string fp = fmt::format("{}\\lotro-data\\lore\\vendors.xml", m_path);
-    if(!m_xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("vendors");
+    xml_node<> *root = xml->doc().first_node("vendors");
     if(!root)
         return false;
+    const VendorSellLists sellLists = getVendorSellLists(root);
     for(xml_node<> *node = root->first_node("sellList");
             node; node = node->next_sibling("sellList"))
     {
@@ -981,41 +1147,36 @@ bool SkillLoader::getVendors(TravelInfo &info)
             if(!attr)
                 continue;
             uint32_t itemId = atoi(attr->value());
-            for(auto &skill : info.skills)
+            for(auto [skill, item] : m_acquireIndex.find(info.skills, itemId))
             {
-                for(auto &item : skill.acquire)
+                attr = node->first_attribute("sellListId");
+                if(!attr)
+                    return false;
+                Barter *vendor = getVendorInfo(attr->value(), sellLists, *item);
+                if(!vendor)
+                    return false;
+
+                vendor->buyAmt = getValueTableValue(*item);
+                uint32_t bartererId = vendor->bartererId;
+                if(!info.findNPC(bartererId))
                 {
-                    if(item.itemId == itemId)
-                    {
-                        attr = node->first_attribute("sellListId");
-                        if(!attr)
-                            return false;
-                        Barter *vendor = getVendorInfo(attr->value(), root, item);
-                        if(!vendor)
-                            return false;
-
-                        vendor->buyAmt = getValueTableValue(item);
-                        uint32_t bartererId = vendor->bartererId;
-                        auto npcIt = ranges::find(info.npcs, bartererId, &NPC::id);
-                        if(npcIt == info.npcs.end())
-                        {
-                            info.npcs.push_back({bartererId});
-                        }
-                    }
+                    info.npcs.push_back({bartererId});
                 }
             }
         }
     }
+    m_docs.evict(fp);
     return true;
 }
 
 bool SkillLoader::getQuests(std::vector<Skill> &skills)
 {
     string fp = fmt::format("{}\\lotro-data\\lore\\quests.xml", m_path);
-    if(!m_xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("quests");
+    xml_node<> *root = xml->doc().first_node("quests");
     if(!root)
         return false;
     for(xml_node<> *node = root->first_node("quest");
@@ -1030,65 +1191,57 @@ bool SkillLoader::getQuests(std::vector<Skill> &skills)
                 xml_attribute<> *attr = objNode->first_attribute("id");
                 if(!attr)
                     continue;
-                bool found = false;
                 uint32_t itemId = atoi(attr->value());
-                for(auto &skill : skills)
+                auto &acquires = m_acquireIndex.find(skills, itemId);
+                if(!acquires.empty())
                 {
-                    auto it = ranges::find(skill.acquire, itemId, &Acquire::itemId);
-                    if(it == skill.acquire.end())
-                        continue;
-
+                    Acquire *acquire = acquires.front().second;
                     if(attr = node->first_attribute("id"); attr)
-                        it->questId = atoi(attr->value());
+                        acquire->questId = atoi(attr->value());
                     attr = node->first_attribute("rawName");
                     if(!attr)
                         return false;
-                    it->questNameKey = attr->value();
-                    found = true;
-                    break;
+                    acquire->questNameKey = attr->value();
                 }
-                if(!found)
+                else
                 {
                     //<object id="1879088537" name="Tattered Map to Glân Vraig"/>
                     if(itemId == 1879088537)
                     {
-                        auto it = ranges::find(skills, 0x7005B38E, &Skill::id);
-                        if(it != skills.end())
+                        Skill *skill = m_skillIndex.find(skills, 0x7005B38E);
+                        if(skill)
                         {
-                            it->acquire.push_back(Acquire{itemId});
-                            auto &acquire = it->acquire.back();
+                            skill->acquire.push_back(Acquire{itemId});
+                            auto &acquire = skill->acquire.back();
                             if(attr = node->first_attribute("id"); attr)
                                 acquire.questId = atoi(attr->value());
                             if(attr = node->first_attribute("rawName"); attr)
                                 acquire.questNameKey = attr->value();
+                            // later rewards of the map resolve to this entry
+                            m_acquireIndex.build(skills);
                         }
                     }
                 }
             }
         }
     }
-
-    getQuestLabels(skills);
+    m_docs.evict(fp);
     return true;
 }
 
 bool SkillLoader::getQuestLabels(std::vector<Skill> &skills)
 {
-    for(const auto &lc : g_lcLabels)
-    {
-        if(!getQuestLabel(lc, skills))
-            return false;
-    }
-    return true;
+    return forEachLocale([&](Locale lc) { return getQuestLabel(lc, skills); });
 }
 
-bool SkillLoader::getQuestLabel(const string &locale, std::vector<Skill> &skills)
+bool SkillLoader::getQuestLabel(Locale locale, std::vector<Skill> &skills)
 {
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\quests.xml", m_path, locale);
-    if(!m_xml.load(fp))
+    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\quests.xml", m_path, lcName(locale));
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("labels");
+    xml_node<> *root = xml->doc().first_node("labels");
     if(!root)
         return false;
 
@@ -1120,18 +1273,19 @@ bool SkillLoader::getQuestLabel(const string &locale, std::vector<Skill> &skills
 
         it->second->questName[locale] = attr->value();
     }
+    m_docs.evict(fp);
     return true;
 }
 
-bool SkillLoader::getAllegianceLabel(const string &locale,
+bool SkillLoader::getAllegianceLabel(Locale locale,
                                      std::vector<Skill> &skills)
 {
-    XMLLoader xml;
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\allegiances.xml", m_path, locale);
-    if(!xml.load(fp))
+    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\allegiances.xml", m_path, lcName(locale));
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = xml.doc().first_node("labels");
+    xml_node<> *root = xml->doc().first_node("labels");
     if(!root)
         return false;
     for(xml_node<> *node = root->first_node("label");
@@ -1156,27 +1310,23 @@ bool SkillLoader::getAllegianceLabel(const string &locale,
             skill.allegiance->name[locale] = attr->value();
         }
     }
+    m_docs.evict(fp);
     return true;
 }
 
 bool SkillLoader::getAllegianceLabels(std::vector<Skill> &skills)
 {
-    for(const auto &lc : g_lcLabels)
-    {
-        if(!getAllegianceLabel(lc, skills))
-            return false;
-    }
-    return true;
+    return forEachLocale([&](Locale lc) { return getAllegianceLabel(lc, skills); });
 }
 
 bool SkillLoader::getAllegiance(std::vector<Skill> &skills)
 {
-    XMLLoader xml;
     string fp = fmt::format("{}\\lotro-data\\lore\\allegiances.xml", m_path);
-    if(!xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = xml.doc().first_node("allegiances");
+    xml_node<> *root = xml->doc().first_node("allegiances");
     if(!root)
         return false;
     for(xml_node<> *node = root->first_node("allegiance");
@@ -1186,8 +1336,8 @@ bool SkillLoader::getAllegiance(std::vector<Skill> &skills)
         if(!attr)
             return false;
         uint32_t skillId = atoi(attr->value());
-        auto it = ranges::find(skills, skillId, &Skill::id);
-        if(it == skills.end())
+        Skill *skill = m_skillIndex.find(skills, skillId);
+        if(!skill)
         {
             fmt::println("MISSING ALLEGIANCE SKILL {}", skillId);
             continue;
@@ -1197,25 +1347,19 @@ bool SkillLoader::getAllegiance(std::vector<Skill> &skills)
         if(!attr)
             return false;
         uint32_t allegianceId = atoi(attr->value());
-        it->allegiance = Allegiance{allegianceId};
+        skill->allegiance = Allegiance{allegianceId};
 
         if(attr = node->first_attribute("minLevel"); attr)
         {
-            it->minLevel = atoi(attr->value());
+            skill->minLevel = atoi(attr->value());
         }
-        if(it->acquireDeed)
+        if(skill->acquireDeed)
         {
-            auto &deed = it->acquireDeed->name.at(EN);
-            const std::regex attr(".*Allegiance Level ([0-9]+)");
-            std::smatch match;
-            if(std::regex_match(deed, match, attr))
-            {
-                string number = match[1].str();
-                it->allegiance->rank = atoi(number.c_str());
-            }
+            if(auto level = matchAllegianceLevel(skill->acquireDeed->name.at(EN)))
+                skill->allegiance->rank = *level;
         }
     }
-    getAllegianceLabels(skills);
+    m_docs.evict(fp);
     return true;
 }
 
@@ -1254,12 +1398,12 @@ static Skill *getItemDeed(const unordered_map<uint32_t, Skill*> &items,
 bool SkillLoader::getDeeds(const unordered_map<string_view, Skill*> &traits,
                            const unordered_map<uint32_t, Skill*> &skills)
 {
-    XMLLoader xml;
     string fp = fmt::format("{}\\lotro-data\\lore\\deeds.xml", m_path);
-    if(!xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = xml.doc().first_node("deeds");
+    xml_node<> *root = xml->doc().first_node("deeds");
     if(!root)
         return false;
     for(xml_node<> *node = root->first_node("deed");
@@ -1310,14 +1454,10 @@ bool SkillLoader::getDeeds(const unordered_map<string_view, Skill*> &traits,
 bool SkillLoader::getTraits(std::vector<Skill> &skills)
 {
     string fp = fmt::format("{}\\lotro-data\\lore\\traits.xml", m_path);
-    if(!m_xml.load(fp))
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    unordered_map<uint32_t, Skill*> skillHash;
-    for(auto &skill : skills)
-    {
-        skillHash.insert({skill.id, &skill});
-    }
     unordered_map<uint32_t, Skill*> items;
     for(auto &skill : skills)
     {
@@ -1327,7 +1467,7 @@ bool SkillLoader::getTraits(std::vector<Skill> &skills)
         }
     }
     unordered_map<string_view, Skill*> traits;
-    xml_node<> *root = m_xml.doc().first_node("traits");
+    xml_node<> *root = xml->doc().first_node("traits");
     if(!root)
         return false;
     for(xml_node<> *node = root->first_node("trait");
@@ -1340,17 +1480,18 @@ bool SkillLoader::getTraits(std::vector<Skill> &skills)
             if(!attr)
                 break;
             uint32_t skillId = atoi(attr->value());
-            auto it = skillHash.find(skillId);
-            if(it != skillHash.end())
+            Skill *skill = m_skillIndex.find(skills, skillId);
+            if(skill)
             {
                 attr = node->first_attribute("identifier");
                 if(attr)
-                    traits.insert({attr->value(), it->second});
+                    traits.insert({attr->value(), skill});
             }
             break;
         }
     }
     getDeeds(traits, items);
+    m_docs.evict(fp);
     getDeedLabels(skills, [](Skill &skill)
             { return skill.acquireDeed ? &skill.acquireDeed.value() : nullptr; });
     return true;
@@ -1358,21 +1499,17 @@ bool SkillLoader::getTraits(std::vector<Skill> &skills)
 
 bool SkillLoader::getDeedLabels(std::vector<Skill> &skills, GetDeedFunc getDeed)
 {
-    for(const auto &lc : g_lcLabels)
-    {
-        if(!getDeedLabel(lc, skills, getDeed))
-            return false;
-    }
-    return true;
+    return forEachLocale([&](Locale lc) { return getDeedLabel(lc, skills, getDeed); });
 }
 
-bool SkillLoader::getDeedLabel(const string &locale, std::vector<Skill> &skills, GetDeedFunc getDeed)
+bool SkillLoader::getDeedLabel(Locale locale, std::vector<Skill> &skills, GetDeedFunc getDeed)
 {
-    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\deeds.xml", m_path, locale);
-    if(!m_xml.load(fp))
+    string fp = fmt::format("{}\\lotro-data\\lore\\labels\\{}\\deeds.xml", m_path, lcName(locale));
+    XMLCache::Document xml = m_docs.load(fp);
+    if(!xml)
         return false;
 
-    xml_node<> *root = m_xml.doc().first_node("labels");
+    xml_node<> *root = xml->doc().first_node("labels");
     if(!root)
         return false;
 
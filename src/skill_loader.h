@@ -1,51 +1,106 @@
 #ifndef SKILL_LOADER_H
 #define SKILL_LOADER_H
 
+#include <algorithm>
+#include <array>
 #include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <functional>
 
-#include "xml_loader.h"
+#include "thread_pool.h"
+#include "xml_cache.h"
+#include "lua_names.h"
+#include "flat_index.h"
 
 using namespace std::literals;
 
-constexpr auto EN = "en";
-constexpr auto DE = "de";
-constexpr auto FR = "fr";
-constexpr auto ES = "es";
-constexpr auto RU = "ru";
-
-const std::vector<std::string> g_lcLabels{ EN, DE, FR, ES, RU };
-const std::vector<std::string> g_lcOutLabels{ "EN", "DE", "FR", "ES", "RU" };
-const std::map<std::string, const char *, std::less<>> g_lcMap{
-    { EN, "EN" }, { DE, "DE" }, { FR, "FR" }, { ES, "ES" }, { RU, "RU"}
+enum class Locale : uint8_t
+{
+    En, De, Fr, Es, Ru
 };
+constexpr size_t LocaleCount = 5;
+
+constexpr Locale EN = Locale::En;
+constexpr Locale DE = Locale::De;
+constexpr Locale FR = Locale::Fr;
+constexpr Locale ES = Locale::Es;
+constexpr Locale RU = Locale::Ru;
+
+constexpr std::array<Locale, LocaleCount> g_lcLabels{ EN, DE, FR, ES, RU };
+
+// lotro-data label folder name
+constexpr std::string_view lcName(Locale locale)
+{
+    constexpr std::array<std::string_view, LocaleCount> names{ "en", "de", "fr", "es", "ru" };
+    return names[static_cast<size_t>(locale)];
+}
 
-using LCLabelMap = std::map<std::string, std::string, std::less<>>;
+// skill_input.toml and Lua table key
+constexpr std::string_view lcOutName(Locale locale)
+{
+    constexpr std::array<std::string_view, LocaleCount> names{ "EN", "DE", "FR", "ES", "RU" };
+    return names[static_cast<size_t>(locale)];
+}
+
+// accepts either the label folder or the output name
+constexpr std::optional<Locale> parseLocale(std::string_view name)
+{
+    for(Locale locale : g_lcLabels)
+    {
+        if(name == lcName(locale) || name == lcOutName(locale))
+            return locale;
+    }
+    return std::nullopt;
+}
 
+constexpr std::optional<Locale> parseOutLocale(std::string_view name)
+{
+    for(Locale locale : g_lcLabels)
+    {
+        if(name == lcOutName(locale))
+            return locale;
+    }
+    return std::nullopt;
+}
+
+// one slot and presence flag per locale; the flags are separate
+// bytes so tasks for different locales can fill one label concurrently
 struct LCLabel
 {
-    const std::string &at(std::string_view locale) const
+    const std::string &at(Locale locale) const
     {
-        static std::string s_empty{""};
-        if(data.contains(locale))
-        {
-            auto it = data.find(locale);
-            if(it != data.end() && it->second != s_empty)
-                return it->second;
-        }
-        if(locale != EN && data.contains(EN))
-            return data.at(EN);
+        static const std::string s_empty{""};
+        if(const std::string *value = find(locale); value && !value->empty())
+            return *value;
+        if(locale != EN && contains(EN))
+            return data[index(EN)];
 
         return s_empty;
     }
-    const size_t size() const { return data.size(); }
-    std::string &operator[](const std::string &name) { return data[name]; }
-    bool empty() const { return data.empty(); }
-    LCLabelMap data;
+    const std::string *find(Locale locale) const
+    {
+        return contains(locale) ? &data[index(locale)] : nullptr;
+    }
+    bool contains(Locale locale) const { return present[index(locale)]; }
+    const size_t size() const { return std::ranges::count(present, true); }
+    std::string &operator[](Locale locale)
+    {
+        present[index(locale)] = true;
+        return data[index(locale)];
+    }
+    bool empty() const { return size() == 0; }
+
+    std::array<std::string, LocaleCount> data;
+    std::array<bool, LocaleCount> present{};
+
+private:
+    static constexpr size_t index(Locale locale) { return static_cast<size_t>(locale); }
 };
 
 struct MapLoc
@@ -196,8 +251,57 @@ struct NPC
     LCLabel title;
 };
 
+// id and descKey lookups into a skill vector; the first skill
+// wins like ranges::find. Rebuilt when the vector was reallocated,
+// replaced or resized since the last lookup
+class SkillIndex
+{
+public:
+    void update(const std::vector<Skill> &skills);
+    Skill *find(std::vector<Skill> &skills, uint32_t id);
+    Skill *findDesc(std::vector<Skill> &skills, std::string_view descKey);
+
+private:
+    std::shared_mutex m_mutex;
+    const Skill *m_data{nullptr};
+    size_t m_size{0};
+    std::unordered_map<uint32_t, size_t> m_ids;
+    std::unordered_map<std::string_view, size_t> m_descKeys;
+};
+
+// itemId to every skill acquire entry for that item in skill then
+// acquire order. Rebuilt when the vector was reallocated, replaced or
+// resized; call build() after acquire lists change in place. Entries
+// found stay valid until the next rebuild. Not locked: the quests,
+// barters and vendors stages that use it run one after the other, and
+// find() and build() must never overlap
+class AcquireIndex
+{
+public:
+    using Entry = std::pair<Skill*, Acquire*>;
+
+    void build(std::vector<Skill> &skills);
+    const std::vector<Entry> &find(std::vector<Skill> &skills, uint32_t itemId);
+
+private:
+    const Skill *m_data{nullptr};
+    size_t m_size{0};
+    std::unordered_map<uint32_t, std::vector<Entry>> m_items;
+};
+
+// one <valueTable> of valueTables.xml; the first quality
+// key and baseValue level seen win like a document scan
+struct ValueTable
+{
+    std::unordered_map<std::string, double> factors;
+    std::unordered_map<unsigned, double> baseValues;
+};
+using ValueTables = std::unordered_map<uint32_t, std::vector<ValueTable>>;
+
+// barterer ids by barterProfile profileId in barters.xml
+using BartererIds = std::unordered_map<uint32_t, std::vector<uint32_t>>;
+
 using FactionLabels = std::map<std::string, LCLabel, std::less<>>;
-using Utf8Map = std::map<std::string_view, std::string_view>;
 
 struct TravelInfo
 {
@@ -209,66 +313,103 @@ struct TravelInfo
     std::vector<Faction> factions;
     std::vector<RepRank> repRanks;
     std::vector<NPC> npcs;
-    Utf8Map strip{{"á", "a"}, {"â", "a"}, {"ê", "e"}, {"ú", "u"},
-                  {"é", "e"}, {"ó", "o"}, {"í", "i"}, {"û", "u"}};
+    LuaNames luaNames; // see buildLuaNames
+
+    // lookups into npcs, currencies and factions; the vectors keep
+    // their order, which is the output order
+    NPC *findNPC(uint32_t id) { return npcIds.find(npcs, id); }
+    const NPC *findNPC(uint32_t id) const { return npcIds.find(npcs, id); }
+    NPC *findNPCTitle(std::string_view titleKey) { return npcTitleKeys.find(npcs, titleKey); }
+    Currency *findCurrency(uint32_t id) { return currencyIds.find(currencies, id); }
+    const Currency *findCurrency(uint32_t id) const { return currencyIds.find(currencies, id); }
+    Faction *findFaction(uint32_t id) { return factionIds.find(factions, id); }
+    const Faction *findFaction(uint32_t id) const { return factionIds.find(factions, id); }
+
+    mutable FlatIndex<NPC, &NPC::id> npcIds;
+    mutable FlatIndex<NPC, &NPC::titleKey> npcTitleKeys; // invalidate after setting title keys
+    mutable FlatIndex<Currency, &Currency::id> currencyIds;
+    mutable FlatIndex<Faction, &Faction::id> factionIds;
 };
 
-
+// stage methods hold their own document handles and the shared
+// indexes lock internally, so stages writing disjoint data may run
+// concurrently on the pool
+//
+// getSkills, getCurrencies and getFactions leave the passes that only
+// fill in labels (skill names, quest, allegiance, currency, NPC and
+// faction labels) to their own methods; see extractLore
 class SkillLoader
 {
 public:
     using GetDeedFunc = std::function<Deed*(Skill&)>;
 
-    SkillLoader(std::string_view root, std::string_view twiiRoot);
+    SkillLoader(std::string_view root, std::string_view twiiRoot,
+                unsigned jobs = ThreadPool::defaultThreads());
 
     std::string getTwiiRoot() const;
 
+    // lotro-data/lore/<file>, lotro-data/lore/labels/<lc>/<file>
+    // and lotro-items-db/items.xml
+    std::string lorePath(std::string_view file) const;
+    std::string labelPath(Locale locale, std::string_view file) const;
+    std::string itemsPath() const;
+    const XMLCache &documents() const { return m_docs; }
+    ThreadPool &pool() { return m_pool; }
+
     std::vector<Skill> getSkills();
 
     bool getSkillNames(std::vector<Skill> &skills);
-    bool getSkillNames(const std::string &locale, std::vector<Skill> &skills);
-    bool getSkillDesc(const std::string &locale, std::vector<Skill> &skills);
+    bool getSkillLabels(Locale locale, std::vector<Skill> &skills,
+                        std::vector<LCLabel> &descs);
     bool getSkillItems(std::vector<Skill> &skills);
     bool getClassInfo(std::vector<Skill> &skills);
     bool getQuests(std::vector<Skill> &skills);
     bool getQuestLabels(std::vector<Skill> &skills);
-    bool getQuestLabel(const std::string &locale, std::vector<Skill> &skills);
+    bool getQuestLabel(Locale locale, std::vector<Skill> &skills);
     bool getTraits(std::vector<Skill> &skills);
     bool getDeeds(const std::unordered_map<std::string_view, Skill*> &traits,
                   const std::unordered_map<uint32_t, Skill*> &skills);
     bool getDeedLabels(std::vector<Skill> &skills, GetDeedFunc getDeed);
-    bool getDeedLabel(const std::string &locale, std::vector<Skill> &skills,
+    bool getDeedLabel(Locale locale, std::vector<Skill> &skills,
                       GetDeedFunc getDeed);
 
     bool getAllegiance(std::vector<Skill> &skills);
     bool getAllegianceLabels(std::vector<Skill> &skills);
-    bool getAllegianceLabel(const std::string &locale, std::vector<Skill> &skills);
+    bool getAllegianceLabel(Locale locale, std::vector<Skill> &skills);
 
     bool getFactions(TravelInfo &info);
     bool getFactionLabels(TravelInfo &info);
-    bool getFactionLabel(const std::string &locale, TravelInfo &info);
+    bool getFactionLabel(Locale locale, TravelInfo &info);
 
     bool getCurrencies(TravelInfo &info);
     bool getCurrencyLabels(TravelInfo &info);
-    bool getCurrencyLabel(const std::string &locale, TravelInfo &info);
+    bool getCurrencyLabel(Locale locale, TravelInfo &info);
 
     bool getVendors(TravelInfo &info);
     bool getBarters(TravelInfo &info);
     bool getNPCTitleKeys(TravelInfo &info);
     bool getNPCLabels(TravelInfo &info);
-    bool getNPCLabel(const std::string &locale, TravelInfo &info);
-    uint32_t getValueTableValue(const Acquire &item);
+    bool getNPCLabel(Locale locale, TravelInfo &info);
+    bool getValueTables();
+    uint32_t getValueTableValue(const Acquire &item) const;
 
 private:
+    bool forEachLocale(const std::function<bool(Locale)> &func);
     std::optional<Deed> getBarterRequiredDeed(uint32_t reqDeedId);
     void addRequiredDeed(std::string_view questKey, Skill &skill);
     void addRequiredFaction(std::string_view factionKey, Skill &skill);
-    void parseBarterRequired(rapidxml::xml_node<> *root, rapidxml::xml_node<> *proNode, TravelInfo &info);
+    void parseBarterRequired(const BartererIds &barterIds,
+                             rapidxml::xml_node<> *proNode, TravelInfo &info);
 
 private:
     std::string m_path;
     std::string m_twiiPath;
-    XMLLoader m_xml;
+    XMLCache m_docs;
+    ThreadPool m_pool;
+    SkillIndex m_skillIndex;
+    AcquireIndex m_acquireIndex;
+    ValueTables m_valueTables;
+    std::mutex m_valueTablesMutex;
 };
 
 #endif // SKILL_LOADER_H
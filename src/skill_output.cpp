@@ -1,11 +1,9 @@
 #include "skill_output.h"
 #include "skill_loader.h"
+#include "output_buffer.h"
+#include "game_patterns.h"
 
-#include <fstream>
-#include <regex>
-#include <set>
 #include <fmt/format.h>
-#include <fmt/ostream.h>
 
 using namespace std;
 
@@ -66,105 +64,54 @@ std::string_view getRegionText(MapLoc::Region region)
     }
 }
 
-void replaceUtf8(string &in, const Utf8Map &strip)
+// rank names that depend on the player's gender use their first form
+static string_view extractNameAttr(const string &in)
 {
-    static std::set<std::string> s_utf8chars;
-    auto s = in.end();
-    for(auto it = in.begin(); it != in.end(); ++it)
-    {
-        if(*it & 0x80)
-        {
-            if(s == in.end())
-            {
-                s = it;
-            }
-        }
-        else if(s != in.end())
-        {
-            string_view value{};
-            auto stripIt = strip.find(string_view{s, it});
-            if(stripIt == strip.end())
-            {
-                auto [_, success] = s_utf8chars.insert(string{s, it});
-                if(success)
-                {
-                    fmt::println("REPLACE UTF8 {}", string_view{s, it});
-                }
-            }
-            else
-            {
-                value = stripIt->second;
-            }
-            in.replace(s, it, value);
-            it = s;
-            s = in.end();
-        }
-    }
-}
-
-static string convertToLuaGVarName(const string &in, const Utf8Map &strip)
-{
-    string out = in;
-    replaceUtf8(out, strip);
-    std::replace(out.begin(), out.end(), ' ', '_');
-    std::replace(out.begin(), out.end(), '-', '_');
-    std::transform(out.begin(), out.end(), out.begin(), ::toupper);
-    std::erase_if(out, [](int c) { return c != '_' && !::isalnum(c); });
-    out = std::regex_replace(out, std::regex("THE_"), "");
-    out = std::regex_replace(out, std::regex("___"), "_");
-    return out;
-}
-
-static string extractNameAttr(const string &in)
-{
-    // ${PLAYERNAME:Verwandter[m]|Verwandte[f]}
-    const std::regex attr("^\\$\\{PLAYERNAME:(.*)\\[.*\\|(.*)\\[.*\\}$");
-    std::smatch matches;
-
-    if(std::regex_match(in, matches, attr))
-    {
-        if(matches.size() >= 3)
-        {
-            return matches[1].str();
-        }
-    }
+    if(auto name = parseGenderedName(in))
+        return name->forms.front().text;
     return in;
 }
 
-static string outputMapLoc(const MapLoc &loc)
+static void outputMapLoc(OutputBuffer &out, const MapLoc &loc)
 {
-    return fmt::format("{{MapType.{}, {}, {}}}", getRegionText(loc.region), loc.x, loc.y);
+    out.print("{{MapType.{}, {}, {}}}", getRegionText(loc.region), loc.x, loc.y);
 }
 
-static string outputMapList(const vector<MapLoc> &locs)
+static void outputMapList(OutputBuffer &out, const vector<MapLoc> &locs)
 {
-    string output;
+    out.append("{");
     for(auto it = locs.begin(); it != locs.end(); ++it)
     {
-        if(std::next(it) != locs.end())
-            output += fmt::format("{},", outputMapLoc(*it));
-        else
-            output += outputMapLoc(*it);
+        if(it != locs.begin())
+            out.append(",");
+        outputMapLoc(out, *it);
     }
-    return fmt::format("{{{}}}", output);
+    out.append("}");
 }
 
-static string outputOverlapIds(const vector<uint32_t> &ids)
+static void outputOverlapIds(OutputBuffer &out, const vector<uint32_t> &ids)
 {
-    string out;
-    string inner;
+    out.append("{");
     for(auto it = ids.begin(); it != ids.end(); ++it)
     {
         if(std::next(it) == ids.end())
-            fmt::format_to(std::back_inserter(inner), "\"0x{:08X}\"", *it);
+            out.print("\"0x{:08X}\"", *it);
         else
-            fmt::format_to(std::back_inserter(inner), "\"0x{:08X}\", ", *it);
+            out.print("\"0x{:08X}\", ", *it);
     }
-    fmt::format_to(std::back_inserter(out), "{{{}}}", inner);
-    return out;
+    out.append("}");
 }
 
-static string outputVendor(const string &locale, const NPC &npc, const Barter &barter)
+// a vendor is labeled by its name or title alone or as "name (title)";
+// the views point into the NPC labels
+struct VendorName
+{
+    string_view name;
+    string_view title;
+    bool titled{false};
+};
+
+static VendorName getVendorName(Locale locale, const NPC &npc, const Barter &barter)
 {
     if(!npc.titleKey.empty())
     {
@@ -177,97 +124,95 @@ static string outputVendor(const string &locale, const NPC &npc, const Barter &b
                 title == "Iron Garrison Miners"sv ||
                 title == "Protector of the Vales"sv)
         {
-            return npc.title.at(locale);
+            return {npc.title.at(locale)};
         }
 
         // mithril
         if(title == "Hunter Trainer"sv && barter.currency[0].id == 1879255991)
         {
-            return npc.title.at(locale);
+            return {npc.title.at(locale)};
         }
 
         if(title == "Warden Trainer"sv && barter.currency[0].id == 1879255991)
         {
-            return npc.title.at(locale);
+            return {npc.title.at(locale)};
         }
 
-        const std::regex attr("^.* Quartermaster$");
-        std::smatch matches;
-        if(std::regex_match(npc.name.at(EN), matches, attr))
+        if(isQuartermaster(npc.name.at(EN)))
         {
-            return npc.name.at(locale);
+            return {npc.name.at(locale)};
         }
         string_view localeTitle = npc.title.at(locale);
         if(locale == RU && localeTitle == "Quartermaster")
         {
             localeTitle = "Интендант";
         }
-        return fmt::format("{} ({})", npc.name.at(locale), localeTitle);
+        return {npc.name.at(locale), localeTitle, true};
     }
-    return npc.name.at(locale);
+    return {npc.name.at(locale)};
+}
+
+static void outputVendor(OutputBuffer &out, const VendorName &vendor)
+{
+    if(vendor.titled)
+        out.print("{} ({})", vendor.name, vendor.title);
+    else
+        out.append(vendor.name);
 }
 
-static string outputDeed(const string &locale, const Skill &skill);
-static string outputVendors(const TravelInfo &info, const Barter &barter, const Skill &skill)
+static void outputDeed(OutputBuffer &out, Locale locale, const Skill &skill);
+static void outputVendors(OutputBuffer &out, const TravelInfo &info,
+                          const Barter &barter, const Skill &skill)
 {
-    string buf;
-    auto it = ranges::find(info.npcs, barter.bartererId, &NPC::id);
-    if(it == info.npcs.end())
-        return buf;
-    auto in = std::back_inserter(buf);
+    const NPC *npc = info.findNPC(barter.bartererId);
+    if(!npc)
+        return;
     for(auto lcIt = g_lcLabels.begin(); lcIt != g_lcLabels.end(); ++lcIt)
     {
-        const std::string &lc = *lcIt;
+        Locale lc = *lcIt;
         const char *end = std::next(lcIt) != g_lcLabels.end() ? ",\n" : "}";
-        fmt::format_to(in, "                {}={{vendor=\"{}\"{}}}{}",
-                g_lcMap.at(lc), outputVendor(lc, *it, barter), outputDeed(lc, skill), end);
+        out.print("                {}={{vendor=\"", lcOutName(lc));
+        outputVendor(out, getVendorName(lc, *npc, barter));
+        out.append("\"");
+        outputDeed(out, lc, skill);
+        out.print("}}{}", end);
     }
-    return buf;
 }
 
-static string outputQuest(const string &locale, const Skill &skill, const Acquire &acquire)
+static void outputQuest(OutputBuffer &out, Locale locale, const Skill &skill,
+                        const Acquire &acquire)
 {
-    string buf;
-    auto in = std::back_inserter(buf);
+    bool first = true;
     if(skill.allegiance)
     {
-        fmt::format_to(in, "allegiance=\"{}\"", skill.allegiance->name.at(locale));
+        out.print("allegiance=\"{}\"", skill.allegiance->name.at(locale));
+        first = false;
     }
-    fmt::format_to(in, "{}quest=\"{}\"",
-                   buf.empty() ? "" : ", ",
-                   acquire.questName.at(locale));
-    return buf;
+    out.print("{}quest=\"{}\"", first ? "" : ", ", acquire.questName.at(locale));
 }
 
-static string outputDeed(const string &locale, const Skill &skill)
+static void outputDeed(OutputBuffer &out, Locale locale, const Skill &skill)
 {
-    string buf;
-    auto out = back_inserter(buf);
+    bool first = true;
     if(skill.allegiance)
     {
-        fmt::format_to(out, "allegiance=\"{}\"", skill.allegiance->name.at(locale));
+        out.print("allegiance=\"{}\"", skill.allegiance->name.at(locale));
+        first = false;
     }
     if(skill.acquireDeed)
     {
-        fmt::format_to(out, "{}deed=\"{}\"",
-                       buf.empty() ? "" : ", ",
-                       skill.acquireDeed->name.at(locale));
+        out.print("{}deed=\"{}\"", first ? "" : ", ", skill.acquireDeed->name.at(locale));
     }
     if(skill.barterDeed)
     {
-        fmt::format_to(out, ", deed=\"{}\"",
-                       skill.barterDeed->name.at(locale));
+        out.print(", deed=\"{}\"", skill.barterDeed->name.at(locale));
     }
-    return buf;
 }
 
-static string outputAllegianceRank(const Skill &skill)
+static void outputAllegianceRank(OutputBuffer &out, const Skill &skill)
 {
-    string buf;
-    auto out = back_inserter(buf);
     if(skill.allegiance && skill.allegiance->rank)
-        fmt::format_to(out, "rank={},", skill.allegiance->rank);
-    return buf;
+        out.print("rank={},", skill.allegiance->rank);
 }
 
 bool operator==(const vector<Token> &lhs, const vector<Token> &rhs)
@@ -284,47 +229,53 @@ bool operator==(const vector<Token> &lhs, const vector<Token> &rhs)
     return false;
 }
 
-static void outputAcquire(ostream &out, const TravelInfo &info, const Skill &skill)
+static void outputAcquire(OutputBuffer &out, const TravelInfo &info, const Skill &skill)
 {
     if(skill.group == Skill::Type::Creep)
         return;
     if(skill.autoLevel)
     {
-        fmt::println(out, "        acquire={{{{autoLevel=true}}}},");
+        out.println("        acquire={{{{autoLevel=true}}}},");
     }
     else if(!skill.acquireDesc.empty())
     {
-        fmt::println(out, "        acquire={{");
-        fmt::println(out, "            {{");
+        out.println("        acquire={{");
+        out.println("            {{");
         for(auto it = g_lcLabels.begin(); it != g_lcLabels.end(); ++it)
         {
-            const std::string &lc = *it;
+            Locale lc = *it;
             const char *end = std::next(it) != g_lcLabels.end() ? "," : "}},";
-            fmt::println(out, "                {}={{desc=\"{}\"}}{}",
-                    g_lcMap.at(lc), skill.acquireDesc.at(lc), end);
+            out.println("                {}={{desc=\"{}\"}}{}",
+                    lcOutName(lc), skill.acquireDesc.at(lc), end);
         }
     }
     else if(skill.acquireDeed)
     {
-        fmt::println(out, "        acquire={{");
-        fmt::println(out, "            {{{}", outputAllegianceRank(skill));
+        out.println("        acquire={{");
+        out.append("            {");
+        outputAllegianceRank(out, skill);
+        out.append("\n");
         for(auto it = g_lcLabels.begin(); it != g_lcLabels.end(); ++it)
         {
-            const std::string &lc = *it;
+            Locale lc = *it;
             const char *end = std::next(it) != g_lcLabels.end() ? ",\n" : "}";
-            fmt::print(out, "                {}={{{}}}{}", g_lcMap.at(lc), outputDeed(lc, skill), end);
+            out.print("                {}={{", lcOutName(lc));
+            outputDeed(out, lc, skill);
+            out.print("}}{}", end);
         }
         if(skill.storeLP)
         {
-            fmt::print(out, ",\n            {{store=true}}");
+            out.print(",\n            {{store=true}}");
         }
-        fmt::println(out, "}},");
+        out.println("}},");
     }
     else
     {
-        string buf;
-        auto in = std::back_inserter(buf);
-        bool firstEntry = true;
+        // the entries go straight after the opening brace and
+        // the whole field is dropped again when none were written
+        const size_t start = out.size();
+        out.append("        acquire={");
+        const size_t entries = out.size();
         if(!skill.acquire.empty())
         {
             bool acquireFront = true;
@@ -337,31 +288,35 @@ static void outputAcquire(ostream &out, const TravelInfo &info, const Skill &ski
                         !acquire.questNameKey.empty() &&
                         !acquire.questName.empty())
                 {
-                    fmt::format_to(in, "{}\n            {{", acquireFront ? "" : ",");
+                    out.print("{}\n            {{", acquireFront ? "" : ",");
                     acquireFront = false;
                     for(auto it = g_lcLabels.begin(); it != g_lcLabels.end(); ++it)
                     {
-                        const std::string &lc = *it;
+                        Locale lc = *it;
                         const char *end = std::next(it) != g_lcLabels.end() ? "," : "}";
-                        fmt::format_to(in, "\n                {}={{{}}}{}",
-                                g_lcMap.at(lc), outputQuest(lc, skill, acquire), end);
+                        out.print("\n                {}={{", lcOutName(lc));
+                        outputQuest(out, lc, skill, acquire);
+                        out.print("}}{}", end);
                     }
                 }
 
                 unordered_map<string, vector<Token>> bartersDone;
                 for(auto &bartersList : acquire.barters)
                 {
-                    auto npcIt = ranges::find(info.npcs, bartersList.bartererId, &NPC::id);
-                    if(npcIt == info.npcs.end())
+                    const NPC *npc = info.findNPC(bartersList.bartererId);
+                    if(!npc)
                         continue;
-                    auto vendorName = outputVendor(EN, *npcIt, bartersList);
+                    VendorName vendor = getVendorName(EN, *npc, bartersList);
+                    string vendorName = vendor.titled ?
+                            fmt::format("{} ({})", vendor.name, vendor.title) :
+                            string{vendor.name};
                     auto done = bartersDone.find(vendorName);
                     if(done != bartersDone.end() && done->second == bartersList.currency)
                     {
                         continue;
                     }
                     bartersDone.insert({std::move(vendorName), bartersList.currency});
-                    fmt::format_to(in, "{}\n            {{cost={{", acquireFront ? "" : ",");
+                    out.print("{}\n            {{cost={{", acquireFront ? "" : ",");
                     acquireFront = false;
 
                     bool tokenFront = true;
@@ -373,178 +328,189 @@ static void outputAcquire(ostream &out, const TravelInfo &info, const Skill &ski
                         unsigned gold = amt / 100000;
                         if(gold)
                         {
-                            fmt::format_to(in, "{}{{amount={}, token=LC.token.GOLD}}",
-                                           tokenFront ? "" : ", ", gold);
+                            out.print("{}{{amount={}, token=LC.token.GOLD}}",
+                                      tokenFront ? "" : ", ", gold);
                             tokenFront = false;
                         }
                         if(silver)
                         {
-                            fmt::format_to(in, "{}{{amount={}, token=LC.token.SILVER}}",
-                                           tokenFront ? "" : ", ", silver);
+                            out.print("{}{{amount={}, token=LC.token.SILVER}}",
+                                      tokenFront ? "" : ", ", silver);
                             tokenFront = false;
                         }
                         if(copper)
                         {
-                            fmt::format_to(in, "{}{{amount={}, token=LC.token.COPPER}}",
-                                           tokenFront ? "" : ", ", copper);
+                            out.print("{}{{amount={}, token=LC.token.COPPER}}",
+                                      tokenFront ? "" : ", ", copper);
                         }
                     }
                     else
                     {
                         for(auto &token : bartersList.currency)
                         {
-                            auto it = ranges::find(info.currencies, token.id, &Currency::id);
-                            if(it == info.currencies.end())
+                            const Currency *currency = info.findCurrency(token.id);
+                            if(!currency)
                             {
                                 fmt::println("CURRENCY NOT FOUND");
+                                out.truncate(start);
                                 return;
                             }
-                            auto tokenName = convertToLuaGVarName(it->name.at(EN), info.strip);
-                            fmt::format_to(in, "{}{{amount={}, token=LC.token.{}}}",
-                                           tokenFront ? "" : ", ", token.amt, tokenName);
+                            const string &tokenName =
+                                info.luaNames.get(LuaNames::Kind::Token, currency->name.at(EN));
+                            out.print("{}{{amount={}, token=LC.token.{}}}",
+                                      tokenFront ? "" : ", ", token.amt, tokenName);
                             tokenFront = false;
                         }
                     }
-                    fmt::format_to(in, "}},\n");
-                    fmt::format_to(in, "{}", outputVendors(info, bartersList, skill));
+                    out.print("}},\n");
+                    outputVendors(out, info, bartersList, skill);
                 }
             }
         }
         if(skill.storeLP)
         {
-            bool addComma = !buf.empty();
-            fmt::format_to(in, "{}{{store=true}}",
-                           addComma ? ",\n           " : "");
+            bool addComma = out.size() != entries;
+            out.print("{}{{store=true}}", addComma ? ",\n           " : "");
         }
 
-        if(!buf.empty())
-        {
-            fmt::println(out, "        acquire={{{}}},", buf);
-        }
+        if(out.size() == entries)
+            out.truncate(start);
+        else
+            out.append("},\n");
     }
 }
 
-static string outputReputation(const Skill &skill, const TravelInfo &info)
+// a missing faction or rank still leaves the caller's line
+static void outputReputation(OutputBuffer &out, const Skill &skill, const TravelInfo &info)
 {
-    string s;
-    auto factionIt = std::ranges::find(info.factions, skill.factionId, &Faction::id);
-    if(factionIt == info.factions.end())
+    const Faction *faction = info.findFaction(skill.factionId);
+    if(!faction)
     {
         fmt::println("MISSING FACTION {}", skill.factionId);
-        return s;
+        return;
     }
-    auto rankIt = factionIt->ranks.find(skill.factionRank);
-    if(rankIt == factionIt->ranks.end())
+    auto rankIt = faction->ranks.find(skill.factionRank);
+    if(rankIt == faction->ranks.end())
     {
         fmt::println("MISSING FACTION RANK {}", skill.factionRank);
-        return s;
+        return;
     }
     auto rankLabelIt = ranges::find(info.repRanks, rankIt->second, &RepRank::key);
     if(rankLabelIt == info.repRanks.end())
     {
         fmt::println("MISSING FACTION RANK LABEL {}", rankIt->second);
-        return s;
+        return;
     }
-    string factionTitle = convertToLuaGVarName(factionIt->name.at(EN), info.strip);
-    string rankTitle = convertToLuaGVarName(rankLabelIt->name.at(EN), info.strip);
-    s = fmt::format("rep=LC.rep.{}, repLevel=LC.repLevel.{},",
-                    factionTitle, rankTitle);
-    return s;
+    const string &factionTitle = info.luaNames.get(LuaNames::Kind::Rep, faction->name.at(EN));
+    const string &rankTitle =
+        info.luaNames.get(LuaNames::Kind::RepLevel, rankLabelIt->name.at(EN));
+    out.print("rep=LC.rep.{}, repLevel=LC.repLevel.{},", factionTitle, rankTitle);
 }
 
-static string outputLabelTag(const LCLabel &tag)
+static void outputLabelTag(OutputBuffer &out, const LCLabel &tag)
 {
-    std::string buf{"{"};
-    auto out = std::back_inserter(buf);
+    out.append("{");
     for(auto it = g_lcLabels.begin(); it != g_lcLabels.end(); ++it)
     {
-        const auto &lc = *it;
+        Locale lc = *it;
         const char *end = std::next(it) != g_lcLabels.end() ? ", " : "}";
-        fmt::format_to(out, "{}=\"{}\"{}", g_lcMap.at(lc), tag.at(lc), end);
+        out.print("{}=\"{}\"{}", lcOutName(lc), tag.at(lc), end);
     }
-    return buf;
 }
 
-static string outputLabelField(std::optional<std::reference_wrapper<const LCLabel>> labelsRef,
-                               std::string_view locale,
-                               std::string_view name)
+static void outputLabelField(OutputBuffer &out,
+                             std::optional<std::reference_wrapper<const LCLabel>> labelsRef,
+                             Locale locale,
+                             std::string_view name)
 {
     if(labelsRef.has_value())
     {
         auto &labels = labelsRef.value().get();
-        auto lclName = labels.at(locale);
+        const string &lclName = labels.at(locale);
         if(name == "desc")
-            return fmt::format(", {}=[[{}]]", name, lclName);
-        if(lclName != "")
-            return fmt::format("{}{}=\"{}\"", name == "name" ? "" : ", ", name, lclName);
+            out.print(", {}=[[{}]]", name, lclName);
+        else if(lclName != "")
+            out.print("{}{}=\"{}\"", name == "name" ? "" : ", ", name, lclName);
     }
-    return {};
 }
 
-static string outputLabelFields(const Skill &skill, std::string_view locale)
+static void outputLabelFields(OutputBuffer &out, const Skill &skill, Locale lc)
 {
-    string lc;
-    std::transform(locale.begin(), locale.end(), std::back_inserter(lc), ::tolower);
+    outputLabelField(out, skill.name, lc, "name");
     if(skill.group == Skill::Type::Creep)
-    {
-        return fmt::format("{}", outputLabelField(skill.name, lc, "name"));
-    }
-    return fmt::format("{}{}{}{}{}{}{}",
-                       outputLabelField(skill.name, lc, "name"),
-                       outputLabelField(skill.desc, lc, "desc"),
-                       outputLabelField(skill.label, lc, "label"),
-                       outputLabelField(skill.tag, lc, "tag"),
-                       outputLabelField(skill.detail, lc, "detail"),
-                       outputLabelField(skill.zlabel, lc, "zlabel"),
-                       outputLabelField(skill.zone, lc, "zone"));
+        return;
+    outputLabelField(out, skill.desc, lc, "desc");
+    outputLabelField(out, skill.label, lc, "label");
+    outputLabelField(out, skill.tag, lc, "tag");
+    outputLabelField(out, skill.detail, lc, "detail");
+    outputLabelField(out, skill.zlabel, lc, "zlabel");
+    outputLabelField(out, skill.zone, lc, "zone");
 }
 
-void outputSkill(ostream &out, const TravelInfo &info, const Skill &skill)
+void buildLuaNames(TravelInfo &info)
 {
-    fmt::println(out, "    self.{}:AddSkill({{", getGroupName(skill.group));
+    info.luaNames.clear();
+    // written by outputLocaleDataFile itself
+    for(string_view token : {"COPPER", "SILVER", "GOLD", "LOTRO_POINT"})
+        info.luaNames.reserve(LuaNames::Kind::Token, token);
+
+    for(const auto &rank : info.repRanks)
+        info.luaNames.add(LuaNames::Kind::RepLevel, rank.name.at(EN));
+    for(const auto &faction : info.factions)
+        info.luaNames.add(LuaNames::Kind::Rep, faction.name.at(EN));
+    for(const auto &currency : info.currencies)
+        info.luaNames.add(LuaNames::Kind::Token, currency.name.at(EN));
+    info.luaNames.reportCollisions();
+}
+
+void outputSkill(OutputBuffer &out, const TravelInfo &info, const Skill &skill)
+{
+    out.println("    self.{}:AddSkill({{", getGroupName(skill.group));
     if(skill.race)
-        fmt::println(out, "        -- {}", *skill.race);
-    fmt::println(out, "        id=\"0x{:08X}\",", skill.id);
-    for(auto lcIt = g_lcLabels.begin(); lcIt != g_lcLabels.end(); ++lcIt)
+        out.println("        -- {}", *skill.race);
+    out.println("        id=\"0x{:08X}\",", skill.id);
+    for(Locale lc : g_lcLabels)
     {
-        const std::string &lc = *lcIt;
-        fmt::println(out, "        {}={{{}}},", g_lcMap.at(lc), outputLabelFields(skill, lc));
+        out.print("        {}={{", lcOutName(lc));
+        outputLabelFields(out, skill, lc);
+        out.append("},\n");
     }
     if(skill.skillTag)
-        fmt::println(out, "        tag=\"{}\",", *skill.skillTag);
-    fmt::println(out, "        map={},", outputMapList(skill.mapList));
+        out.println("        tag=\"{}\",", *skill.skillTag);
+    out.append("        map=");
+    outputMapList(out, skill.mapList);
+    out.append(",\n");
     if(!skill.overlapIds.empty())
     {
-        fmt::println(out, "        overlap={},", outputOverlapIds(skill.overlapIds));
+        out.append("        overlap=");
+        outputOverlapIds(out, skill.overlapIds);
+        out.append(",\n");
     }
     outputAcquire(out, info, skill);
     if(skill.factionId)
     {
-        fmt::println(out, "        {}", outputReputation(skill, info));
+        out.append("        ");
+        outputReputation(out, skill, info);
+        out.append("\n");
     }
     if(skill.minLevel && skill.group != Skill::Type::Creep)
     {
-        fmt::println(out, "        minLevel={},", skill.minLevel);
+        out.println("        minLevel={},", skill.minLevel);
     }
     else if(skill.minLevelInput)
     {
-        fmt::println(out, "        minLevel={}, -- config", skill.minLevelInput);
+        out.println("        minLevel={}, -- config", skill.minLevelInput);
     }
-    fmt::println(out, "        level={}", skill.sortLevel);
-    fmt::println(out, "    }})");
+    out.println("        level={}", skill.sortLevel);
+    out.println("    }})");
 }
 
-void outputSkillDataFile(const TravelInfo &info)
+bool outputSkillDataFile(const TravelInfo &info, const string &path,
+                         OutputSummary &summary)
 {
-    std::ofstream out("SkillData.lua", ios::out | ios::binary);
-    if(!out.is_open())
-    {
-        fmt::println("Failed to create SkillData.lua");
-        return;
-    }
-
-    fmt::println(out, "---[[ auto-generated travel skills ]] --\n\n");
-    fmt::println(out, "function TravelDictionary:CreateDictionaries()");
+    OutputBuffer out;
+    out.println("---[[ auto-generated travel skills ]] --\n\n");
+    out.println("function TravelDictionary:CreateDictionaries()");
     auto groups = {Skill::Type::Hunter, Skill::Type::Warden, Skill::Type::Mariner,
         Skill::Type::Racial, Skill::Type::Gen, Skill::Type::Rep, Skill::Type::Creep};
     for(auto group : groups)
@@ -552,12 +518,13 @@ void outputSkillDataFile(const TravelInfo &info)
         auto groupName = getGroupName(group);
         auto tagIt = info.labelTags.find(group);
         if(group == Skill::Type::Creep)
-            fmt::println(out, "end\n\nfunction TravelDictionary:CreateCreepDictionary()");
-        fmt::println(out, "    -- add the {} skills", groupName);
+            out.println("end\n\nfunction TravelDictionary:CreateCreepDictionary()");
+        out.println("    -- add the {} skills", groupName);
         if(tagIt != info.labelTags.end())
         {
-            fmt::println(out, "    self.{}:AddLabelTag({})",
-                         groupName, outputLabelTag(tagIt->second));
+            out.print("    self.{}:AddLabelTag(", groupName);
+            outputLabelTag(out, tagIt->second);
+            out.append(")\n");
         }
 
         for(auto &skill : info.skills)
@@ -568,21 +535,18 @@ void outputSkillDataFile(const TravelInfo &info)
             outputSkill(out, info, skill);
         }
         if(group == Skill::Type::Creep)
-            fmt::println(out, "end");
+            out.println("end");
     }
+
+    return summary.write(path, out);
 }
 
-void outputLocaleDataFile(const TravelInfo &info)
+bool outputLocaleDataFile(const TravelInfo &info, const string &path,
+                          OutputSummary &summary)
 {
-    std::ofstream out("LocaleData.lua", ios::out | ios::binary);
-    if(!out.is_open())
-    {
-        fmt::println("Failed to create LocaleData.lua");
-        return;
-    }
-
-    fmt::println(out, "---[[ auto-generated travel skill locale data ]] --\n\n");
-    fmt::println(out, "local Locale = {{\n"
+    OutputBuffer out;
+    out.println("---[[ auto-generated travel skill locale data ]] --\n\n");
+    out.println("local Locale = {{\n"
                       "    [Turbine.Language.English] = {{}},\n"
                       "    [Turbine.Language.German] = {{}},\n"
                       "    [Turbine.Language.French] = {{}},\n"
@@ -594,7 +558,7 @@ void outputLocaleDataFile(const TravelInfo &info)
                       "local LC_FR = Locale[Turbine.Language.French]\n"
                       "local LC_ES = Locale[Turbine.Language.Spanish]\n"
                       "local LC_RU = Locale[Turbine.Language.Russian]\n");
-    fmt::println(out, "if GLocale == Turbine.Language.German then\n"
+    out.println("if GLocale == Turbine.Language.German then\n"
                       "    LC_DE = LC\n"
                       "elseif GLocale == Turbine.Language.French then\n"
                       "    LC_FR = LC\n"
@@ -606,84 +570,86 @@ void outputLocaleDataFile(const TravelInfo &info)
                       "    LC_EN = LC\n"
                       "end\n");
 
-    fmt::println(out, "LC_EN.repLevel = {{}}");
-    fmt::println(out, "LC_DE.repLevel = {{}}");
-    fmt::println(out, "LC_FR.repLevel = {{}}");
-    fmt::println(out, "LC_ES.repLevel = {{}}");
-    fmt::println(out, "LC_RU.repLevel = {{}}");
-    fmt::println(out, "");
+    out.println("LC_EN.repLevel = {{}}");
+    out.println("LC_DE.repLevel = {{}}");
+    out.println("LC_FR.repLevel = {{}}");
+    out.println("LC_ES.repLevel = {{}}");
+    out.println("LC_RU.repLevel = {{}}");
+    out.println("");
 
     for(const auto &rank : info.repRanks)
     {
-        auto title = convertToLuaGVarName(rank.name.at(EN), info.strip);
-        fmt::println(out, "LC_EN.repLevel.{} = \"{}\"",
+        const string &title = info.luaNames.get(LuaNames::Kind::RepLevel, rank.name.at(EN));
+        out.println("LC_EN.repLevel.{} = \"{}\"",
                      title, extractNameAttr(rank.name.at(EN)));
-        fmt::println(out, "LC_DE.repLevel.{} = \"{}\"",
+        out.println("LC_DE.repLevel.{} = \"{}\"",
                      title, extractNameAttr(rank.name.at(DE)));
-        fmt::println(out, "LC_FR.repLevel.{} = \"{}\"",
+        out.println("LC_FR.repLevel.{} = \"{}\"",
                      title, extractNameAttr(rank.name.at(FR)));
-        fmt::println(out, "LC_ES.repLevel.{} = \"{}\"",
+        out.println("LC_ES.repLevel.{} = \"{}\"",
                      title, extractNameAttr(rank.name.at(ES)));
-        fmt::println(out, "LC_RU.repLevel.{} = \"{}\"",
+        out.println("LC_RU.repLevel.{} = \"{}\"",
                      title, extractNameAttr(rank.name.at(RU)));
-        fmt::println(out, "");
+        out.println("");
     }
 
-    fmt::println(out, "LC_EN.rep = {{}}");
-    fmt::println(out, "LC_DE.rep = {{}}");
-    fmt::println(out, "LC_FR.rep = {{}}");
-    fmt::println(out, "LC_ES.rep = {{}}");
-    fmt::println(out, "LC_RU.rep = {{}}");
-    fmt::println(out, "");
+    out.println("LC_EN.rep = {{}}");
+    out.println("LC_DE.rep = {{}}");
+    out.println("LC_FR.rep = {{}}");
+    out.println("LC_ES.rep = {{}}");
+    out.println("LC_RU.rep = {{}}");
+    out.println("");
 
     for(const auto &faction : info.factions)
     {
-        auto title = convertToLuaGVarName(faction.name.at(EN), info.strip);
-        fmt::println(out, "LC_EN.rep.{} = \"{}\"", title, faction.name.at(EN));
-        fmt::println(out, "LC_DE.rep.{} = \"{}\"", title, faction.name.at(DE));
-        fmt::println(out, "LC_FR.rep.{} = \"{}\"", title, faction.name.at(FR));
-        fmt::println(out, "LC_ES.rep.{} = \"{}\"", title, faction.name.at(ES));
-        fmt::println(out, "LC_RU.rep.{} = \"{}\"", title, faction.name.at(RU));
-        fmt::println(out, "");
-    }
-
-    fmt::println(out, "LC_EN.token = {{}}");
-    fmt::println(out, "LC_DE.token = {{}}");
-    fmt::println(out, "LC_FR.token = {{}}");
-    fmt::println(out, "LC_ES.token = {{}}");
-    fmt::println(out, "LC_RU.token = {{}}");
-    fmt::println(out, "");
-    fmt::println(out, "LC_EN.token.COPPER = \"Copper\"");
-    fmt::println(out, "LC_DE.token.COPPER = \"Kupfer\"");
-    fmt::println(out, "LC_FR.token.COPPER = \"Cuivre\"");
-    fmt::println(out, "LC_ES.token.COPPER = \"Cobre\"");
-    fmt::println(out, "LC_RU.token.COPPER = \"Медь\"");
-    fmt::println(out, "");
-    fmt::println(out, "LC_EN.token.SILVER = \"Silver\"");
-    fmt::println(out, "LC_DE.token.SILVER = \"Silber\"");
-    fmt::println(out, "LC_FR.token.SILVER = \"Argent\"");
-    fmt::println(out, "LC_ES.token.SILVER = \"Plata\"");
-    fmt::println(out, "LC_RU.token.SILVER = \"Серебро\"");
-    fmt::println(out, "");
-    fmt::println(out, "LC_EN.token.GOLD = \"Gold\"");
-    fmt::println(out, "LC_DE.token.GOLD = \"Gold\"");
-    fmt::println(out, "LC_FR.token.GOLD = \"Or\"");
-    fmt::println(out, "LC_ES.token.GOLD = \"Oro\"");
-    fmt::println(out, "LC_RU.token.GOLD = \"Золото\"");
-    fmt::println(out, "");
-    fmt::println(out, "LC_EN.token.LOTRO_POINT = \"LOTRO Points\"");
-    fmt::println(out, "LC_DE.token.LOTRO_POINT = \"HdRO-Punkte\"");
-    fmt::println(out, "LC_FR.token.LOTRO_POINT = \"Points SdAO\"");
-    fmt::println(out, "LC_ES.token.LOTRO_POINT = \"Puntos LOTRO\"");
-    fmt::println(out, "LC_RU.token.LOTRO_POINT = \"ВКО марки\"");
+        const string &title = info.luaNames.get(LuaNames::Kind::Rep, faction.name.at(EN));
+        out.println("LC_EN.rep.{} = \"{}\"", title, faction.name.at(EN));
+        out.println("LC_DE.rep.{} = \"{}\"", title, faction.name.at(DE));
+        out.println("LC_FR.rep.{} = \"{}\"", title, faction.name.at(FR));
+        out.println("LC_ES.rep.{} = \"{}\"", title, faction.name.at(ES));
+        out.println("LC_RU.rep.{} = \"{}\"", title, faction.name.at(RU));
+        out.println("");
+    }
+
+    out.println("LC_EN.token = {{}}");
+    out.println("LC_DE.token = {{}}");
+    out.println("LC_FR.token = {{}}");
+    out.println("LC_ES.token = {{}}");
+    out.println("LC_RU.token = {{}}");
+    out.println("");
+    out.println("LC_EN.token.COPPER = \"Copper\"");
+    out.println("LC_DE.token.COPPER = \"Kupfer\"");
+    out.println("LC_FR.token.COPPER = \"Cuivre\"");
+    out.println("LC_ES.token.COPPER = \"Cobre\"");
+    out.println("LC_RU.token.COPPER = \"Медь\"");
+    out.println("");
+    out.println("LC_EN.token.SILVER = \"Silver\"");
+    out.println("LC_DE.token.SILVER = \"Silber\"");
+    out.println("LC_FR.token.SILVER = \"Argent\"");
+    out.println("LC_ES.token.SILVER = \"Plata\"");
+    out.println("LC_RU.token.SILVER = \"Серебро\"");
+    out.println("");
+    out.println("LC_EN.token.GOLD = \"Gold\"");
+    out.println("LC_DE.token.GOLD = \"Gold\"");
+    out.println("LC_FR.token.GOLD = \"Or\"");
+    out.println("LC_ES.token.GOLD = \"Oro\"");
+    out.println("LC_RU.token.GOLD = \"Золото\"");
+    out.println("");
+    out.println("LC_EN.token.LOTRO_POINT = \"LOTRO Points\"");
+    out.println("LC_DE.token.LOTRO_POINT = \"HdRO-Punkte\"");
+    out.println("LC_FR.token.LOTRO_POINT = \"Points SdAO\"");
+    out.println("LC_ES.token.LOTRO_POINT = \"Puntos LOTRO\"");
+    out.println("LC_RU.token.LOTRO_POINT = \"ВКО марки\"");
     for(const auto &currency : info.currencies)
     {
-        auto title = convertToLuaGVarName(currency.name.at(EN), info.strip);
-        fmt::println(out, "");
-        fmt::println(out, "LC_EN.token.{} = \"{}\"", title, currency.name.at(EN));
-        fmt::println(out, "LC_DE.token.{} = \"{}\"", title, currency.name.at(DE));
-        fmt::println(out, "LC_FR.token.{} = \"{}\"", title, currency.name.at(FR));
-        fmt::println(out, "LC_ES.token.{} = \"{}\"", title, currency.name.at(ES));
-        fmt::println(out, "LC_RU.token.{} = \"{}\"", title, currency.name.at(RU));
+        const string &title = info.luaNames.get(LuaNames::Kind::Token, currency.name.at(EN));
+        out.println("");
+        out.println("LC_EN.token.{} = \"{}\"", title, currency.name.at(EN));
+        out.println("LC_DE.token.{} = \"{}\"", title, currency.name.at(DE));
+        out.println("LC_FR.token.{} = \"{}\"", title, currency.name.at(FR));
+        out.println("LC_ES.token.{} = \"{}\"", title, currency.name.at(ES));
+        out.println("LC_RU.token.{} = \"{}\"", title, currency.name.at(RU));
     }
+
+    return summary.write(path, out);
 }
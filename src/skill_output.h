@@ -4,8 +4,15 @@
 #include "skill_loader.h"
 
 struct TravelInfo;
-void outputSkillDataFile(const TravelInfo &info);
-void outputLocaleDataFile(const TravelInfo &info);
+class OutputSummary;
+bool outputSkillDataFile(const TravelInfo &info, const std::string &path,
+                         OutputSummary &summary);
+bool outputLocaleDataFile(const TravelInfo &info, const std::string &path,
+                          OutputSummary &summary);
+
+// converts the faction, rep rank and currency names once and
+// reports names that share an identifier; run before the writers
+void buildLuaNames(TravelInfo &info);
 
 std::string_view getRegionText(MapLoc::Region region);
 std::string_view getGroupName(Skill::Type type);
@@ -0,0 +1,84 @@
+#include "string_kernels.h"
+#include "transliterate.h"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+string fixXmlStr(string_view str)
+{
+    string buf;
+    buf.reserve(str.size());
+    size_t pos = 0;
+    for(size_t i; (i = str.find("\\q", pos)) != string_view::npos; pos = i + 2)
+    {
+        buf.append(str.substr(pos, i - pos));
+        buf.append("\\\"");
+    }
+    buf.append(str.substr(pos));
+    return buf;
+}
+
+string escQuote(const string &in)
+{
+    string out;
+    out.reserve(in.size() + ranges::count(in, '"'));
+    size_t pos = 0;
+    for(size_t i; (i = in.find('"', pos)) != string::npos; pos = i + 1)
+    {
+        out.append(in, pos, i - pos);
+        out.append("\\\"");
+    }
+    out.append(in, pos);
+    return out;
+}
+
+string convertToLuaGVarName(const string &in)
+{
+    string out;
+    transliterate(in, out);
+
+    // spaces and dashes become '_', everything else but letters
+    // and digits is dropped
+    size_t size = 0;
+    for(char c : out)
+    {
+        if(c == ' ' || c == '-')
+            c = '_';
+        auto uc = static_cast<unsigned char>(c);
+        if(c == '_' || ::isalnum(uc))
+            out[size++] = static_cast<char>(::toupper(uc));
+    }
+    out.resize(size);
+
+    // drops every "THE_" and then turns each "___" of what is left into
+    // "_", both left to right without rescanning; a run of n underscores
+    // left after the first step ends up as n / 3 + n % 3 of them
+    size = 0;
+    size_t underscores = 0;
+    auto flush = [&]
+    {
+        for(size_t i = underscores / 3 + underscores % 3; i; --i)
+            out[size++] = '_';
+        underscores = 0;
+    };
+    for(size_t i = 0; i < out.size(); ++i)
+    {
+        if(out.compare(i, 4, "THE_") == 0)
+        {
+            i += 3;
+            continue;
+        }
+        if(out[i] == '_')
+        {
+            ++underscores;
+            continue;
+        }
+        flush();
+        out[size++] = out[i];
+    }
+    flush();
+    out.resize(size);
+    return out;
+}
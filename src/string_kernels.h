@@ -0,0 +1,21 @@
+#ifndef STRING_KERNELS_H
+#define STRING_KERNELS_H
+
+#include <string>
+#include <string_view>
+
+// Single pass string rewrites used while reading labels and writing output
+//
+// Each one replaces a std::regex rewrite; --check-kernels runs them next to
+// the old regex versions over the label files and reports any difference.
+
+// labels escape quotes as \q, which becomes \"
+std::string fixXmlStr(std::string_view str);
+
+// escapes every '"' as \" for skill_input.toml
+std::string escQuote(const std::string &in);
+
+// EN name to the identifier used in LC.rep, LC.repLevel and LC.token
+std::string convertToLuaGVarName(const std::string &in);
+
+#endif // STRING_KERNELS_H
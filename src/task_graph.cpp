@@ -0,0 +1,140 @@
+#include "task_graph.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <fmt/format.h>
+#include "profiler.h"
+
+using namespace std;
+using namespace std::chrono_literals;
+
+TaskGraph::Id TaskGraph::add(std::string name, Func func, std::vector<Id> deps)
+{
+    const Id id = m_stages.size();
+    for(Id dep : deps)
+    {
+        if(dep >= id)
+        {
+            fmt::println("TASK GRAPH: {} depends on a later stage", name);
+            continue;
+        }
+        m_stages[dep].dependents.push_back(id);
+    }
+    m_stages.push_back({std::move(name), std::move(func), std::move(deps)});
+    return id;
+}
+
+bool TaskGraph::runSerial()
+{
+    bool ok = true;
+    for(auto &stage : m_stages)
+    {
+        bool ready = ranges::all_of(stage.deps, [this](Id dep)
+            { return m_stages[dep].state == State::Done; });
+        if(!ready)
+        {
+            stage.state = State::Skipped;
+            continue;
+        }
+        {
+            ProfileScope scope(stage.name);
+            stage.state = stage.func() ? State::Done : State::Failed;
+        }
+        if(stage.state == State::Failed)
+        {
+            fmt::println("TASK GRAPH: stage {} failed", stage.name);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool TaskGraph::run(ThreadPool &pool)
+{
+    if(!pool.size())
+        return runSerial();
+
+    mutex finishedMutex;
+    condition_variable finishedCond;
+    deque<Id> finished;
+    vector<size_t> waiting(m_stages.size());
+    size_t remaining = m_stages.size();
+
+    auto start = [&](Id id)
+    {
+        pool.submit([&, id]
+        {
+            bool ok;
+            {
+                ProfileScope scope(m_stages[id].name);
+                ok = m_stages[id].func();
+            }
+            // notify under the lock; run() may return once it sees the id
+            lock_guard lock(finishedMutex);
+            m_stages[id].state = ok ? State::Done : State::Failed;
+            finished.push_back(id);
+            finishedCond.notify_one();
+        });
+    };
+
+    // stages whose dependency failed are skipped along with their dependents
+    function<void(Id)> skip = [&](Id id)
+    {
+        if(m_stages[id].state == State::Skipped)
+            return;
+        m_stages[id].state = State::Skipped;
+        --remaining;
+        for(Id next : m_stages[id].dependents)
+            skip(next);
+    };
+
+    for(Id id = 0; id < m_stages.size(); ++id)
+    {
+        waiting[id] = m_stages[id].deps.size();
+        if(!waiting[id])
+            start(id);
+    }
+
+    bool ok = true;
+    while(remaining)
+    {
+        // help with queued work so graphs may run from inside pool tasks
+        Id id;
+        for(;;)
+        {
+            {
+                lock_guard lock(finishedMutex);
+                if(!finished.empty())
+                {
+                    id = finished.front();
+                    finished.pop_front();
+                    break;
+                }
+            }
+            if(!pool.runPending())
+            {
+                unique_lock lock(finishedMutex);
+                finishedCond.wait_for(lock, 1ms, [&] { return !finished.empty(); });
+            }
+        }
+        --remaining;
+
+        Stage &stage = m_stages[id];
+        if(stage.state == State::Failed)
+        {
+            fmt::println("TASK GRAPH: stage {} failed", stage.name);
+            ok = false;
+            for(Id next : stage.dependents)
+                skip(next);
+            continue;
+        }
+        for(Id next : stage.dependents)
+        {
+            if(m_stages[next].state == State::Waiting && !--waiting[next])
+                start(next);
+        }
+    }
+    return ok;
+}
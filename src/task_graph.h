@@ -0,0 +1,48 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "thread_pool.h"
+
+// stages with declared dependencies; a stage runs once every stage it
+// depends on succeeded. Stages must be added after their dependencies,
+// and that order is the run order on a pool without workers
+class TaskGraph
+{
+public:
+    using Id = size_t;
+    using Func = std::function<bool()>;
+
+    Id add(std::string name, Func func, std::vector<Id> deps = {});
+    bool run(ThreadPool &pool);
+
+    size_t size() const { return m_stages.size(); }
+
+private:
+    enum class State
+    {
+        Waiting,
+        Done,
+        Failed,
+        Skipped
+    };
+
+    struct Stage
+    {
+        std::string name;
+        Func func;
+        std::vector<Id> deps;
+        std::vector<Id> dependents;
+        State state{State::Waiting};
+    };
+
+    bool runSerial();
+
+private:
+    std::vector<Stage> m_stages;
+};
+
+#endif // TASK_GRAPH_H
@@ -0,0 +1,63 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+// NOTE: a pool of one thread runs tasks inline on submit
+//       so single threaded runs keep the caller's order
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if(threads <= 1)
+        return;
+
+    m_workers.reserve(threads);
+    for(unsigned i = 0; i < threads; ++i)
+        m_workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for(auto &worker : m_workers)
+        worker.join();
+}
+
+unsigned ThreadPool::defaultThreads()
+{
+    unsigned threads = thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+void ThreadPool::run()
+{
+    for(;;)
+    {
+        function<void()> task;
+        {
+            unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if(m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+bool ThreadPool::runPending()
+{
+    function<void()> task;
+    {
+        lock_guard lock(m_mutex);
+        if(m_tasks.empty())
+            return false;
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+    }
+    task();
+    return true;
+}
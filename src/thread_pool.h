@@ -0,0 +1,81 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "profiler.h"
+
+// fixed set of worker threads running queued tasks in FIFO order
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threads = defaultThreads());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template<typename Func>
+    auto submit(Func &&func) -> std::future<std::invoke_result_t<Func>>
+    {
+        using Result = std::invoke_result_t<Func>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        auto result = task->get_future();
+        if(m_workers.empty())
+        {
+            (*task)();
+            return result;
+        }
+        {
+            // queued work is charged to the stage that submitted it
+            std::lock_guard lock(m_mutex);
+            m_tasks.emplace_back([task, stage = Profiler::current()]
+            {
+                ProfileScope scope(stage);
+                (*task)();
+            });
+        }
+        m_wake.notify_one();
+        return result;
+    }
+
+    // waits for a task's result; queued tasks are run meanwhile
+    // so tasks may submit and wait on further tasks without
+    // starving the workers
+    template<typename Result>
+    Result wait(std::future<Result> &result)
+    {
+        using namespace std::chrono_literals;
+        while(result.wait_for(0s) != std::future_status::ready)
+        {
+            if(!runPending())
+                result.wait_for(1ms);
+        }
+        return result.get();
+    }
+
+    // runs one queued task on the calling thread, if any
+    bool runPending();
+
+    unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+    static unsigned defaultThreads();
+
+private:
+    void run();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop{false};
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,154 @@
+#include "transliterate.h"
+
+#include <map>
+#include <mutex>
+#include <fmt/format.h>
+
+using namespace std;
+
+// nullptr marks codepoints without a spelling; the C1 controls are
+// not expected in labels, so they are reported too
+static constexpr const char *s_latin[256] = {
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, // U+0080
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, // U+0088
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, // U+0090
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, // U+0098
+    " ", "", "", "", "", "", "", "", // U+00A0
+    "", "", "a", "", "", "", "", "", // U+00A8
+    "", "", "2", "3", "", "", "", "", // U+00B0
+    "", "1", "o", "", "", "", "", "", // U+00B8
+    "A", "A", "A", "A", "A", "A", "AE", "C", // U+00C0
+    "E", "E", "E", "E", "I", "I", "I", "I", // U+00C8
+    "D", "N", "O", "O", "O", "O", "O", "x", // U+00D0
+    "O", "U", "U", "U", "U", "Y", "TH", "ss", // U+00D8
+    "a", "a", "a", "a", "a", "a", "ae", "c", // U+00E0
+    "e", "e", "e", "e", "i", "i", "i", "i", // U+00E8
+    "d", "n", "o", "o", "o", "o", "o", "", // U+00F0
+    "o", "u", "u", "u", "u", "y", "th", "y", // U+00F8
+    "A", "a", "A", "a", "A", "a", "C", "c", // U+0100
+    "C", "c", "C", "c", "C", "c", "D", "d", // U+0108
+    "D", "d", "E", "e", "E", "e", "E", "e", // U+0110
+    "E", "e", "E", "e", "G", "g", "G", "g", // U+0118
+    "G", "g", "G", "g", "H", "h", "H", "h", // U+0120
+    "I", "i", "I", "i", "I", "i", "I", "i", // U+0128
+    "I", "i", "IJ", "ij", "J", "j", "K", "k", // U+0130
+    "k", "L", "l", "L", "l", "L", "l", "L", // U+0138
+    "l", "L", "l", "N", "n", "N", "n", "N", // U+0140
+    "n", "n", "N", "n", "O", "o", "O", "o", // U+0148
+    "O", "o", "OE", "oe", "R", "r", "R", "r", // U+0150
+    "R", "r", "S", "s", "S", "s", "S", "s", // U+0158
+    "S", "s", "T", "t", "T", "t", "T", "t", // U+0160
+    "U", "u", "U", "u", "U", "u", "U", "u", // U+0168
+    "U", "u", "U", "u", "W", "w", "Y", "y", // U+0170
+    "Y", "Z", "z", "Z", "z", "Z", "z", "s", // U+0178
+};
+
+static constexpr const char *s_cyrillic[256] = {
+    "E", "Yo", "Dj", "G", "Ye", "Dz", "I", "Yi", // U+0400
+    "J", "Lj", "Nj", "C", "K", "I", "U", "Dz", // U+0408
+    "A", "B", "V", "G", "D", "E", "Zh", "Z", // U+0410
+    "I", "Y", "K", "L", "M", "N", "O", "P", // U+0418
+    "R", "S", "T", "U", "F", "Kh", "Ts", "Ch", // U+0420
+    "Sh", "Shch", "", "Y", "", "E", "Yu", "Ya", // U+0428
+    "a", "b", "v", "g", "d", "e", "zh", "z", // U+0430
+    "i", "y", "k", "l", "m", "n", "o", "p", // U+0438
+    "r", "s", "t", "u", "f", "kh", "ts", "ch", // U+0440
+    "sh", "shch", "", "y", "", "e", "yu", "ya", // U+0448
+    "e", "yo", "dj", "g", "ye", "dz", "i", "yi", // U+0450
+    "j", "lj", "nj", "c", "k", "i", "u", "dz", // U+0458
+    "O", "o", "E", "e", "Ye", "ye", "Ya", "ya", // U+0460
+    "Ya", "ya", "U", "u", "Yu", "yu", "Ks", "ks", // U+0468
+    "Ps", "ps", "F", "f", "Y", "y", "Y", "y", // U+0470
+    "U", "u", "O", "o", "O", "o", "Ot", "ot", // U+0478
+    "Q", "q", "", "", "", "", "", "", // U+0480
+    "", "", "Y", "y", "", "", "R", "r", // U+0488
+    "G", "g", "Gh", "gh", "Gh", "gh", "Zh", "zh", // U+0490
+    "Z", "z", "Q", "q", "K", "k", "K", "k", // U+0498
+    "Q", "q", "Ng", "ng", "Ng", "ng", "P", "p", // U+04A0
+    "H", "h", "S", "s", "T", "t", "U", "u", // U+04A8
+    "U", "u", "H", "h", "Ts", "ts", "Ch", "ch", // U+04B0
+    "Ch", "ch", "H", "h", "Ch", "ch", "Ch", "ch", // U+04B8
+    "", "Zh", "zh", "K", "k", "L", "l", "N", // U+04C0
+    "n", "N", "n", "Ch", "ch", "M", "m", "", // U+04C8
+    "A", "a", "A", "a", "Ae", "ae", "E", "e", // U+04D0
+    "A", "a", "A", "a", "Zh", "zh", "Z", "z", // U+04D8
+    "Dz", "dz", "I", "i", "I", "i", "O", "o", // U+04E0
+    "O", "o", "O", "o", "E", "e", "U", "u", // U+04E8
+    "U", "u", "U", "u", "Ch", "ch", "G", "g", // U+04F0
+    "Y", "y", "G", "g", "H", "h", "H", "h", // U+04F8
+};
+
+static std::mutex s_unknownMutex;
+static std::map<char32_t, size_t> s_unknown;
+
+// U+FFFD stands in for malformed sequences
+static void countUnknown(char32_t cp)
+{
+    lock_guard lock(s_unknownMutex);
+    ++s_unknown[cp];
+}
+
+static const char *lookup(char32_t cp)
+{
+    if(cp >= 0x80 && cp < 0x180)
+        return s_latin[cp - 0x80];
+    if(cp >= 0x400 && cp < 0x500)
+        return s_cyrillic[cp - 0x400];
+    return nullptr;
+}
+
+// decodes the sequence at text[pos], advancing pos past it;
+// a malformed sequence only skips its first byte
+static char32_t decode(string_view text, size_t &pos)
+{
+    auto byte = [&](size_t i) { return static_cast<unsigned char>(text[i]); };
+    unsigned char lead = byte(pos);
+    size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if(lead >= 0xF8 || !length || pos + length > text.size())
+    {
+        ++pos;
+        return 0xFFFD;
+    }
+
+    char32_t cp = lead & (0x7F >> length);
+    for(size_t i = 1; i < length; ++i)
+    {
+        if((byte(pos + i) & 0xC0) != 0x80)
+        {
+            ++pos;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (byte(pos + i) & 0x3F);
+    }
+    pos += length;
+    return cp;
+}
+
+void transliterate(string_view text, string &out)
+{
+    out.reserve(out.size() + text.size());
+    size_t pos = 0;
+    while(pos < text.size())
+    {
+        // copy the ASCII run up to the next multibyte sequence
+        size_t start = pos;
+        while(pos < text.size() && !(text[pos] & 0x80))
+            ++pos;
+        out.append(text.substr(start, pos - start));
+        if(pos == text.size())
+            break;
+
+        char32_t cp = decode(text, pos);
+        if(const char *ascii = lookup(cp))
+            out.append(ascii);
+        else
+            countUnknown(cp);
+    }
+}
+
+void reportUnknownCodepoints()
+{
+    lock_guard lock(s_unknownMutex);
+    for(auto [cp, count] : s_unknown)
+        fmt::println("UTF8: no ASCII spelling for U+{:04X} ({} times)", static_cast<uint32_t>(cp), count);
+}
@@ -0,0 +1,18 @@
+#ifndef TRANSLITERATE_H
+#define TRANSLITERATE_H
+
+#include <string>
+#include <string_view>
+
+// appends an ASCII spelling of UTF-8 text to out
+//
+// Latin-1 Supplement, Latin Extended-A and Cyrillic letters map to their
+// base letters or a common romanization; punctuation and signs from those
+// blocks are dropped. Any other codepoint, and malformed UTF-8, is dropped
+// and counted for reportUnknownCodepoints
+void transliterate(std::string_view text, std::string &out);
+
+// prints each codepoint that had no spelling once, with its count
+void reportUnknownCodepoints();
+
+#endif // TRANSLITERATE_H
@@ -0,0 +1,71 @@
+#include "xml_cache.h"
+#include "profiler.h"
+
+using namespace std;
+
+XMLCache::Document XMLCache::load(const std::string &path)
+{
+    Profiler::count(Profiler::Counter::Lookups);
+    shared_ptr<Entry> entry;
+    {
+        lock_guard lock(m_mutex);
+        auto [it, inserted] = m_docs.try_emplace(path);
+        if(inserted)
+        {
+            ++m_misses;
+            it->second = make_shared<Entry>();
+        }
+        else
+        {
+            ++m_hits;
+        }
+        entry = it->second;
+    }
+
+    // parse outside the lock so other documents load in parallel
+    call_once(entry->parsed, [&]
+    {
+        auto xml = make_shared<XMLLoader>();
+        if(xml->load(path))
+            entry->xml = std::move(xml);
+    });
+    if(entry->xml)
+        return entry->xml;
+
+    // failed loads are not cached
+    lock_guard lock(m_mutex);
+    auto it = m_docs.find(path);
+    if(it != m_docs.end() && it->second == entry)
+        m_docs.erase(it);
+    return nullptr;
+}
+
+void XMLCache::evict(const std::string &path)
+{
+    lock_guard lock(m_mutex);
+    m_docs.erase(path);
+}
+
+void XMLCache::clear()
+{
+    lock_guard lock(m_mutex);
+    m_docs.clear();
+}
+
+size_t XMLCache::size() const
+{
+    lock_guard lock(m_mutex);
+    return m_docs.size();
+}
+
+size_t XMLCache::hits() const
+{
+    lock_guard lock(m_mutex);
+    return m_hits;
+}
+
+size_t XMLCache::misses() const
+{
+    lock_guard lock(m_mutex);
+    return m_misses;
+}
@@ -0,0 +1,43 @@
+#ifndef XML_CACHE_H
+#define XML_CACHE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "xml_loader.h"
+
+// parsed documents keyed by path; a document stays cached until it is
+// evicted so stages reading the same file share one parse. Load returns
+// a handle that keeps the document and its nodes alive past an evict,
+// so concurrent tasks may load and evict any path
+class XMLCache
+{
+public:
+    using Document = std::shared_ptr<XMLLoader>;
+
+    XMLCache() = default;
+
+    Document load(const std::string &path);
+    void evict(const std::string &path);
+    void clear();
+
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    struct Entry
+    {
+        std::once_flag parsed;
+        Document xml;
+    };
+
+    std::unordered_map<std::string, std::shared_ptr<Entry>> m_docs;
+    mutable std::mutex m_mutex;
+    size_t m_hits{0};
+    size_t m_misses{0};
+};
+
+#endif // XML_CACHE_H
@@ -1,13 +1,84 @@
 #include "xml_loader.h"
+#include "profiler.h"
 
 #include <fstream>
+#include <mutex>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
+static XMLLoader::Mode s_mode{XMLLoader::Mode::Buffered};
+static XMLLoader::Stats s_stats;
+static std::mutex s_statsMutex;
+
+XMLLoader::~XMLLoader()
+{
+    m_doc.clear();
+    unmap();
+}
+
+void XMLLoader::setMode(Mode mode)
+{
+    s_mode = mode;
+}
+
+XMLLoader::Mode XMLLoader::mode()
+{
+    return s_mode;
+}
+
+XMLLoader::Stats XMLLoader::stats()
+{
+    lock_guard lock(s_statsMutex);
+    return s_stats;
+}
+
+// element count of a parsed document, only taken for --profile
+static size_t countNodes(rapidxml::xml_node<> *node)
+{
+    size_t count = 0;
+    for(auto *child = node->first_node(); child; child = child->next_sibling())
+    {
+        if(child->type() == rapidxml::node_element)
+            count += 1 + countNodes(child);
+    }
+    return count;
+}
+
 bool XMLLoader::load(const std::string &path)
 {
     m_doc.clear();
+    unmap();
+
+    if(s_mode == Mode::Mapped && loadMapped(path))
+    {
+        m_doc.parse<0>(m_map);
+    }
+    else
+    {
+        if(!loadBuffered(path))
+            return false;
+        m_doc.parse<0>(m_buf.data());
+    }
+
+    if(Profiler::enabled())
+    {
+        Profiler::count(Profiler::Counter::Bytes, m_map ? m_mapSize : m_buf.size());
+        Profiler::count(Profiler::Counter::Nodes, countNodes(&m_doc));
+    }
+    return true;
+}
 
+bool XMLLoader::loadBuffered(const std::string &path)
+{
     ifstream f;
     f.open(path, ios::in | ios::binary | ios::ate);
     if(!f.is_open())
@@ -22,6 +93,87 @@ bool XMLLoader::load(const std::string &path)
         return false;
     }
 
-    m_doc.parse<0>(m_buf.data());
+    lock_guard lock(s_statsMutex);
+    ++s_stats.filesCopied;
+    s_stats.bytesCopied += m_buf.size();
     return true;
 }
+
+// NOTE: rapidxml needs a zero terminated buffer and parses in-situ,
+//       so the view is mapped copy-on-write and only used when the
+//       file does not end on a page boundary (the tail is zero filled)
+bool XMLLoader::loadMapped(const std::string &path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fsize{};
+    SYSTEM_INFO sysInfo{};
+    GetSystemInfo(&sysInfo);
+    if(!GetFileSizeEx(file, &fsize) || fsize.QuadPart == 0 ||
+            fsize.QuadPart % sysInfo.dwPageSize == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(!mapping)
+        return false;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if(!view)
+        return false;
+
+    m_map = static_cast<char *>(view);
+    m_mapSize = static_cast<size_t>(fsize.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st{};
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if(fstat(fd, &st) != 0 || st.st_size == 0 ||
+            pageSize <= 0 || st.st_size % pageSize == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *view = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED)
+        return false;
+
+    m_map = static_cast<char *>(view);
+    m_mapSize = static_cast<size_t>(st.st_size);
+#endif
+
+    m_buf.clear();
+    m_buf.shrink_to_fit();
+    lock_guard lock(s_statsMutex);
+    ++s_stats.filesMapped;
+    s_stats.bytesMapped += m_mapSize;
+    return true;
+}
+
+void XMLLoader::unmap()
+{
+    if(!m_map)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_map);
+#else
+    munmap(m_map, m_mapSize);
+#endif
+    m_map = nullptr;
+    m_mapSize = 0;
+}
@@ -7,12 +7,41 @@
 class XMLLoader
 {
 public:
+    enum class Mode
+    {
+        Buffered, // read the file into m_buf
+        Mapped // private copy-on-write mapping; falls back to Buffered
+    };
+
+    struct Stats
+    {
+        size_t filesMapped{0};
+        size_t bytesMapped{0};
+        size_t filesCopied{0};
+        size_t bytesCopied{0};
+    };
+
     XMLLoader() = default;
+    ~XMLLoader();
+    XMLLoader(const XMLLoader &) = delete;
+    XMLLoader &operator=(const XMLLoader &) = delete;
+
     bool load(const std::string &path);
     rapidxml::xml_document<> &doc() { return m_doc; };
 
+    static void setMode(Mode mode);
+    static Mode mode();
+    static Stats stats();
+
+private:
+    bool loadMapped(const std::string &path);
+    bool loadBuffered(const std::string &path);
+    void unmap();
+
 private:
     std::string m_buf;
+    char *m_map{nullptr};
+    size_t m_mapSize{0};
     rapidxml::xml_document<> m_doc;
 };
 